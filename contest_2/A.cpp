@@ -1,65 +1,14 @@
+#include <charconv>
 #include <iostream>
-#include <limits>
-#include <stack>
+#include <string>
 #include <vector>
 
-struct Node {
-    int value, pref_max;
-
-    Node(int value, int pref_max) : value(value), pref_max(pref_max) {}
-};
-
-struct MaxStack {
-    std::stack<Node> max_stack;
-
-    bool Empty() const { return max_stack.empty(); }
-    void Push(int value) {
-        Node current_node = Node(value, value);
-        if (!max_stack.empty()) {
-            current_node.pref_max = std::max(max_stack.top().pref_max, value);
-        }
-        max_stack.push(current_node);
-    }
-
-    int GetMax() const { return max_stack.top().pref_max; }
-
-    int Top() const { return max_stack.top().value; }
-
-    void Pop() { return max_stack.pop(); }
-};
-
-struct MaxQueue {
-    MaxStack back;
-    MaxStack front;
-    static const int kMin = std::numeric_limits<int>::min();
-
-    bool Empty() const { return front.Empty() && back.Empty(); }
-
-    void PushBack(int value) { back.Push(value); }
-
-    void PopFront() {
-        if (front.Empty()) {
-            while (!back.Empty()) {
-                front.Push(back.Top());
-                back.Pop();
-            }
-        }
-        front.Pop();
-    }
-
-    int GetMax() const {
-        int current_max = kMin;
-        if (!back.Empty()) {
-            current_max = std::max(current_max, back.GetMax());
-        }
-        if (!front.Empty()) {
-            current_max = std::max(current_max, front.GetMax());
-        }
-        return current_max;
-    }
-};
+#include "max_queue.h"
 
 int main() {
+    std::ios_base::sync_with_stdio(false);
+    std::cin.tie(nullptr);
+
     int array_size;
     std::cin >> array_size;
 
@@ -68,13 +17,18 @@ int main() {
         std::cin >> x;
     }
 
-    MaxQueue max_queue;
+    MaxQueue<int> max_queue(array_size);
 
     int right_index = 0;
     max_queue.PushBack(array[0]);
 
     int queries;
     std::cin >> queries;
+
+    const int kMaxNumberLength = 12;
+    std::string output(static_cast<size_t>(queries) * kMaxNumberLength, ' ');
+    char* output_end = output.data();
+
     for (int query = 0; query < queries; ++query) {
         char direction;
         std::cin >> direction;
@@ -86,9 +40,14 @@ int main() {
             max_queue.PushBack(array[right_index]);
         }
 
-        std::cout << max_queue.GetMax() << ' ';
+        output_end = std::to_chars(output_end, output_end + kMaxNumberLength,
+                                   max_queue.GetMax())
+                         .ptr;
+        *output_end++ = ' ';
     }
-    std::cout << std::endl;
+    output.resize(output_end - output.data());
+
+    std::cout << output << std::endl;
 
     return 0;
-}
\ No newline at end of file
+}
@@ -1,21 +1,12 @@
 #include <cstdint>
 #include <iostream>
+#include <iterator>
 #include <numeric>
 #include <ostream>
-#include <random>
 #include <vector>
 
-struct Player {
-    int64_t efficiency;
-    int index;
-
-    static bool CompByEfficiency(const Player& lhs, const Player& rhs) {
-        return lhs.efficiency < rhs.efficiency;
-    }
-    static bool CompByIndex(const Player& lhs, const Player& rhs) {
-        return lhs.index < rhs.index;
-    }
-};
+#include "custom_sort.h"
+#include "player.h"
 
 std::vector<Player> InputPlayersVector(std::istream& in = std::cin) {
     int players_size;
@@ -36,65 +27,6 @@ struct PlayersTeam {
     Iterator last;
 };
 
-namespace CustomSort {
-
-template <typename Iterator, typename Generator>
-Iterator SelectPivot(Iterator first, Iterator last, Generator generator) {
-    size_t distance = std::distance(first, last);
-
-    std::uniform_int_distribution<int> distrib(0, distance - 1);
-
-    const int kPivotIndex = distrib(generator);
-    return first + kPivotIndex;
-}
-
-template <typename Iterator, typename Predicate>
-Iterator Partition(Iterator first, Iterator last, Predicate pred) {
-    Iterator split_it = first;
-
-    for (Iterator current_it = first; current_it != last; ++current_it) {
-        if (pred(*current_it)) {
-            std::iter_swap(split_it, current_it);
-            ++split_it;
-        }
-    }
-
-    return split_it;
-}
-
-template <typename Iterator, typename Comparator, typename Generator>
-void QuickSort(Iterator first, Iterator last, Comparator comparator,
-               const Generator& generator) {
-    if (std::distance(first, last) <= 1) {
-        return;
-    }
-
-    const auto kPivot = *SelectPivot(first, last, generator);
-
-    const Iterator kEqualIterator =
-        Partition(first, last, [kPivot, comparator](const auto& elem) {
-            return comparator(elem, kPivot);
-        });
-
-    const Iterator kGreaterIterator =
-        Partition(kEqualIterator, last, [kPivot, comparator](const auto& elem) {
-            return !comparator(kPivot, elem);
-        });
-
-    QuickSort(first, kEqualIterator, comparator, generator);
-    QuickSort(kGreaterIterator, last, comparator, generator);
-}
-
-template <typename Iterator, typename Comparator>
-void QuickSort(Iterator first, Iterator last, Comparator comparator) {
-    const int kRandomState = 667;
-    static std::mt19937 random_generator(kRandomState);
-
-    QuickSort(first, last, comparator, random_generator);
-}
-
-}  // namespace CustomSort
-
 std::vector<Player> BuildMostEffectiveSolidaryTeam(
     std::vector<Player> players) {
     if (players.size() <= 2) {
@@ -102,8 +34,7 @@ std::vector<Player> BuildMostEffectiveSolidaryTeam(
     }
     using Iterator = std::vector<Player>::iterator;
 
-    CustomSort::QuickSort(players.begin(), players.end(),
-                          Player::CompByEfficiency);
+    CustomSort::SortByKey(players.begin(), players.end(), Player::Efficiency);
 
     int64_t best_summary_effectiveness = 0;
     int64_t current_summary_effectiveness = 0;
@@ -153,7 +84,7 @@ int64_t SummaryEfficiency(const std::vector<Player>& players) {
 
 std::ostream& PrintTeam(std::vector<Player> players,
                         std::ostream& os = std::cout) {
-    CustomSort::QuickSort(players.begin(), players.end(), Player::CompByIndex);
+    CustomSort::SortByKey(players.begin(), players.end(), Player::Index);
     os << SummaryEfficiency(players) << std::endl;
     for (const Player& player : players) {
         os << player.index << ' ';
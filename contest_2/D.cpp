@@ -1,120 +1,73 @@
-#include <cassert>
+#include <algorithm>
 #include <cstdint>
 #include <iostream>
-#include <random>
+#include <span>
+#include <string>
 #include <vector>
 
-template <typename T>
-void Print(const std::vector<T>& array, int left_index, int right_index) {
-    for (int index = left_index; index < right_index; ++index) {
-        std::cout << array[index] << ' ';
-    }
-    std::cout << std::endl;
-}
-
-class Generator {
-private:
-    unsigned int a_, b_;
-    unsigned int cur_ = 0;
-
-    static const unsigned int kEight = 8;
-
-    unsigned int NextRand24() {
-        cur_ = cur_ * a_ + b_;  // вычисляется с переполнениями
-        return cur_ >> kEight;  // число от 0 до 2**24-1.
-    }
-
-public:
-    Generator(unsigned int current_a, unsigned int current_b)
-        : a_(current_a), b_(current_b) {}
-
-    unsigned int NextRand32() {
-        unsigned int current_a = NextRand24();
-        unsigned int current_b = NextRand24();
-        return (current_a << kEight) ^ current_b;  // число от 0 до 2**32-1.
-    }
-};
-
-int SelectPivot(int left_index, int right_index) {
-    static std::mt19937 rng(std::random_device{}());
-    std::uniform_int_distribution<int> distrib(left_index, right_index - 1);
-    int pivot_index = distrib(rng);
-
-    return pivot_index;
+#include "array_statistics.h"
+#include "lcg_generator.h"
+#include "radix_select.h"
+
+// larger arrays are not stored: the generator is run twice for
+// RadixSelect, which needs O(2^16) memory
+const int64_t kMaxStoredSize = int64_t{1} << 27;
+const int64_t kStreamChunkSize = 1 << 16;
+
+std::string ToString(RadixSelect::UInt128 value) {
+    std::string digits;
+    do {
+        digits.push_back('0' + static_cast<int>(value % 10));
+        value /= 10;
+    } while (value != 0);
+    std::reverse(digits.begin(), digits.end());
+    return digits;
 }
 
-template <typename T>
-void Partition(std::vector<T>& array, int left_index, int right_index,
-               int& left_part_end, int& right_part_start, T pivot_value) {
-    int i = left_index;
-    left_part_end = left_index;
-    right_part_start = right_index - 1;
-
-    while (i <= right_part_start) {
-        if (array[i] < pivot_value) {
-            std::swap(array[left_part_end], array[i]);
-            ++left_part_end;
-            ++i;
-        } else if (array[i] > pivot_value) {
-            std::swap(array[i], array[right_part_start]);
-            --right_part_start;
-        } else {
-            ++i;
+RadixSelect::UInt128 StreamAbsoluteDeviationSum(int64_t array_size,
+                                                unsigned int current_a,
+                                                unsigned int current_b) {
+    auto replay = [&](auto visit) {
+        Generator gen(current_a, current_b);
+        std::vector<int64_t> chunk(kStreamChunkSize);
+        for (int64_t done = 0; done < array_size; done += kStreamChunkSize) {
+            std::span<int64_t> part(
+                chunk.data(), std::min(kStreamChunkSize, array_size - done));
+            gen.Fill(part);
+            for (int64_t value : part) {
+                visit(static_cast<uint32_t>(value));
+            }
         }
-    }
-}
-
-template <typename T>
-T GetKStatistics(std::vector<T>& array, int left_index, int right_index,
-                 int current_k, int depth = 0) {
-    while (true) {
-        if (left_index >= right_index) {
-            assert(false);
-        }
-        if (right_index - left_index == 1) {
-            return array[left_index];
-        }
-
-        const int pivot_index = SelectPivot(left_index, right_index);
-        const T pivot_value = array[pivot_index];
-
-        int left_part_end, right_part_start;
-        Partition(array, left_index, right_index, left_part_end,
-                  right_part_start, pivot_value);
-
-        if (current_k < left_part_end) {
-            right_index = left_part_end;
-        } else if (current_k > right_part_start) {
-            left_index = right_part_start + 1;
-        } else {
-            return pivot_value;
-        }
-    }
+    };
+    return RadixSelect::Select(replay, array_size / 2).absolute_deviation_sum;
 }
 
 int main() {
-    int array_size;
+    int64_t array_size;
     std::cin >> array_size;
 
     unsigned int current_a;
     unsigned int current_b;
     std::cin >> current_a >> current_b;
 
+    if (array_size > kMaxStoredSize) {
+        std::cout << ToString(StreamAbsoluteDeviationSum(
+                         array_size, current_a, current_b))
+                  << std::endl;
+        return 0;
+    }
+
     Generator gen(current_a, current_b);
 
     std::vector<int64_t> array(array_size);
-    for (int index = 0; index < array_size; ++index) {
-        array[index] = gen.NextRand32();
-    }
-
-    int64_t median_value = GetKStatistics(array, 0, array_size, array_size / 2);
+    gen.Fill(array);
 
-    int64_t answer = 0;
-    for (auto x : array) {
-        answer += (x >= median_value) ? x - median_value : median_value - x;
-    }
+    const double kMedianLevel = 0.5;
+    const int64_t kAnswer = ArrayStatistics::Compute(array, {kMedianLevel})
+                                .quantiles[0]
+                                .absolute_deviation_sum;
 
-    std::cout << answer << std::endl;
+    std::cout << kAnswer << std::endl;
 
     return 0;
 }
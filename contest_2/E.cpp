@@ -22,28 +22,41 @@ struct SegmentTime {
     void UpdateIfPossible();
 };
 
+// Times of the segments of one length len: index l holds the segment
+// [l, l + len - 1]. The segment [l, r] needs only [l, r - 1] and [l + 1, r]
+// of the previous length, which are at l and l + 1, so the lengths are
+// rolled in place from left to right and memory is O(n) instead of O(n^2).
+struct DiagonalTimes {
+    std::vector<int> left_index_time;
+    std::vector<int> right_index_time;
+};
+
 int array_size;
 std::vector<Point> array;
-std::vector<std::vector<SegmentTime>> dp;
+DiagonalTimes dp;
 
 int GetDistance(int start_index, int finish_index) {
     return std::abs(array[start_index].x - array[finish_index].x);
 }
 
+// dp at left_index and left_index + 1 holds [l, r - 1] and [l + 1, r],
+// [l, r] is written at left_index
 void UpdateDp(int left_index, int right_index) {
+    const int kShorterLeftTime = dp.left_index_time[left_index];
+    const int kShorterRightTime = dp.right_index_time[left_index];
+    const int kShiftedLeftTime = dp.left_index_time[left_index + 1];
+    const int kShiftedRightTime = dp.right_index_time[left_index + 1];
     SegmentTime updated_segment_time = SegmentTime();
 
     // 1) end_l = [l, r - 1].r + [r - 1, r] + [l, r]
     // 2) end_l = [l + 1, r].l + [l, l + 1]
     // 3) end_l = [l + 1, r].r + [l, r]
     updated_segment_time.left_index_time =
-        std::min({dp[left_index][right_index - 1].right_index_time +
+        std::min({kShorterRightTime +
                       GetDistance(right_index - 1, right_index) +
                       GetDistance(right_index, left_index),
-                  dp[left_index + 1][right_index].left_index_time +
-                      GetDistance(left_index + 1, left_index),
-                  dp[left_index + 1][right_index].right_index_time +
-                      GetDistance(left_index, right_index)});
+                  kShiftedLeftTime + GetDistance(left_index + 1, left_index),
+                  kShiftedRightTime + GetDistance(left_index, right_index)});
     // check if not expired time
     if (updated_segment_time.left_index_time >
         array[left_index].expiration_time) {
@@ -54,13 +67,10 @@ void UpdateDp(int left_index, int right_index) {
     // 2) end_r = [l + 1, r].l + [l, l + 1] + [l, r]
     // 3) end_r = [l, r - 1].l + [l, r] ?
     updated_segment_time.right_index_time =
-        std::min({dp[left_index][right_index - 1].right_index_time +
-                      GetDistance(right_index - 1, right_index),
-                  dp[left_index + 1][right_index].left_index_time +
-                      GetDistance(left_index, left_index + 1) +
+        std::min({kShorterRightTime + GetDistance(right_index - 1, right_index),
+                  kShiftedLeftTime + GetDistance(left_index, left_index + 1) +
                       GetDistance(left_index, right_index),
-                  dp[left_index][right_index - 1].left_index_time +
-                      GetDistance(left_index, right_index)});
+                  kShorterLeftTime + GetDistance(left_index, right_index)});
     // check if not expired time
     if (updated_segment_time.right_index_time >
         array[right_index].expiration_time) {
@@ -77,16 +87,10 @@ void UpdateDp(int left_index, int right_index) {
                  updated_segment_time.left_index_time +
                      GetDistance(left_index, right_index));
 
-    if (updated_segment_time.left_index_time <
-        dp[left_index][right_index].left_index_time) {
-        dp[left_index][right_index].left_index_time =
-            updated_segment_time.left_index_time;
-    }
-    if (updated_segment_time.right_index_time <
-        dp[left_index][right_index].right_index_time) {
-        dp[left_index][right_index].right_index_time =
-            updated_segment_time.right_index_time;
-    }
+    dp.left_index_time[left_index] =
+        std::min(updated_segment_time.left_index_time, SegmentTime::kInf);
+    dp.right_index_time[left_index] =
+        std::min(updated_segment_time.right_index_time, SegmentTime::kInf);
 }
 
 int main() {
@@ -98,19 +102,17 @@ int main() {
 
     std::sort(array.begin(), array.end());
 
-    dp.assign(array_size, std::vector<SegmentTime>(array_size, SegmentTime()));
-
-    for (int index = 0; index < array_size; ++index) {
-        dp[index][index] = SegmentTime(0, 0);
-    }
+    // segments of length 1
+    dp.left_index_time.assign(array_size, 0);
+    dp.right_index_time.assign(array_size, 0);
 
     for (int index = 0; index + 1 < array_size; ++index) {
         const int kCurrentDist = GetDistance(index, index + 1);
 
-        dp[index][index + 1].left_index_time =
+        dp.left_index_time[index] =
             (kCurrentDist <= array[index].expiration_time ? kCurrentDist
                                                           : SegmentTime::kInf);
-        dp[index][index + 1].right_index_time =
+        dp.right_index_time[index] =
             (kCurrentDist <= array[index + 1].expiration_time
                  ? kCurrentDist
                  : SegmentTime::kInf);
@@ -126,8 +128,7 @@ int main() {
         }
     }
 
-    int min_time = std::min(dp[0][array_size - 1].left_index_time,
-                            dp[0][array_size - 1].right_index_time);
+    int min_time = std::min(dp.left_index_time[0], dp.right_index_time[0]);
 
     if (min_time >= SegmentTime::kInf) {
         std::cout << "No solution";
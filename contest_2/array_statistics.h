@@ -0,0 +1,201 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "k_statistics.h"
+
+// Quantiles of one array together with the sum of absolute deviations from
+// each of them and the number of elements below and above each of them.
+//
+// All quantile ranks are selected by one KStatistics::MultiSelect. After
+// it the elements before the position of every quantile are not greater
+// than it and the ones after are not less, so
+//   sum |x - q| = q * before - sum(before) + sum(after) - q * after,
+// and the only pass over the data sums the segments between consecutive
+// quantile positions. The same pass counts the elements of every segment
+// equal to the quantiles at its ends, which turns the positions into the
+// numbers of elements less and greater than each quantile. The loops have
+// independent accumulators, which the compiler vectorizes, and no branches.
+//
+// Sums of integral values are int64_t: n * max |x| must be below 2^63, so
+// 32-bit values are fine up to 2^31 elements.
+namespace ArrayStatistics {
+
+const int kSumLanes = 8;
+
+// int64_t for integral values, double otherwise
+template <typename T>
+using Sum = std::conditional_t<std::is_integral_v<T>, int64_t, double>;
+
+template <typename T>
+struct Quantile {
+    // requested level in [0, 1], the rank is min(floor(level * n), n - 1)
+    double level;
+    int64_t rank;
+    T value;
+    // numbers of elements less and greater than value
+    int64_t below_count;
+    int64_t above_count;
+    // sum and mean of |x - value| over the array
+    Sum<T> absolute_deviation_sum;
+    double mean_absolute_deviation;
+};
+
+template <typename T>
+struct Statistics {
+    int64_t count;
+    Sum<T> sum;
+    double mean;
+    // in the order of the requested levels
+    std::vector<Quantile<T>> quantiles;
+};
+
+template <typename T>
+struct Segment {
+    Sum<T> sum;
+    // elements equal to lower and to upper
+    int64_t lower_count;
+    int64_t upper_count;
+};
+
+template <typename T>
+Segment<T> Summarize(const T* values, size_t size, T lower, T upper) {
+    Sum<T> sums[kSumLanes] = {};
+    int64_t lower_counts[kSumLanes] = {};
+    int64_t upper_counts[kSumLanes] = {};
+    const size_t kRounds = size / kSumLanes;
+    for (size_t round = 0; round < kRounds; ++round) {
+        for (int lane = 0; lane < kSumLanes; ++lane) {
+            const T kValue = values[round * kSumLanes + lane];
+            sums[lane] += kValue;
+            lower_counts[lane] += kValue == lower;
+            upper_counts[lane] += kValue == upper;
+        }
+    }
+    Segment<T> segment{0, 0, 0};
+    for (size_t index = kRounds * kSumLanes; index < size; ++index) {
+        segment.sum += values[index];
+        segment.lower_count += values[index] == lower;
+        segment.upper_count += values[index] == upper;
+    }
+    for (int lane = 0; lane < kSumLanes; ++lane) {
+        segment.sum += sums[lane];
+        segment.lower_count += lower_counts[lane];
+        segment.upper_count += upper_counts[lane];
+    }
+    return segment;
+}
+
+// Segment s is array[sorted_ranks[s - 1], sorted_ranks[s]) with the ranks
+// extended by 0 and the size. It holds its lower quantile, and its values
+// are between the quantiles at its ends.
+template <typename T>
+std::vector<Segment<T>> SummarizeSegments(
+    const std::vector<T>& array, const std::vector<int64_t>& sorted_ranks) {
+    const size_t kQuantileCount = sorted_ranks.size();
+    std::vector<Segment<T>> segments;
+    for (size_t index = 0; index <= kQuantileCount; ++index) {
+        const int64_t kFirst = index > 0 ? sorted_ranks[index - 1] : 0;
+        const int64_t kLast =
+            index < kQuantileCount ? sorted_ranks[index] : array.size();
+        const T kLower = array[kFirst];
+        const T kUpper = index < kQuantileCount ? array[kLast] : kLower;
+        segments.push_back(
+            Summarize(array.data() + kFirst, kLast - kFirst, kLower, kUpper));
+    }
+    return segments;
+}
+
+// {below, above} counts of the quantile at sorted_ranks[index]: equal
+// elements are counted in the segments next to it, and further on while
+// the neighbouring quantile is equal too, as such segments are constant
+template <typename T>
+std::pair<int64_t, int64_t> CountsAround(
+    const std::vector<T>& array, const std::vector<int64_t>& sorted_ranks,
+    const std::vector<Segment<T>>& segments, size_t index) {
+    const T kValue = array[sorted_ranks[index]];
+    auto quantile_equals = [&](size_t other) {
+        return array[sorted_ranks[other]] == kValue;
+    };
+    int64_t equal_before = 0;
+    for (size_t segment = index + 1; segment-- > 0;) {
+        equal_before += segments[segment].upper_count;
+        if (segment == 0 || !quantile_equals(segment - 1)) {
+            break;
+        }
+    }
+    int64_t equal_after = 0;
+    for (size_t segment = index + 1; segment < segments.size(); ++segment) {
+        equal_after += segments[segment].lower_count;
+        if (segment == sorted_ranks.size() || !quantile_equals(segment)) {
+            break;
+        }
+    }
+    const int64_t kPosition = sorted_ranks[index];
+    return {kPosition - equal_before,
+            static_cast<int64_t>(array.size()) - kPosition - equal_after};
+}
+
+// array is reordered, levels must be in [0, 1]
+template <typename T>
+Statistics<T> Compute(std::vector<T>& array, const std::vector<double>& levels,
+                      uint64_t seed = KStatistics::kDefaultSeed) {
+    const int64_t kSize = array.size();
+    Statistics<T> statistics{kSize, 0, 0, {}};
+    if (kSize == 0) {
+        return statistics;
+    }
+
+    std::vector<int64_t> ranks;
+    for (double level : levels) {
+        ranks.push_back(
+            std::min<int64_t>(std::floor(level * kSize), kSize - 1));
+    }
+    std::vector<int64_t> sorted_ranks = ranks;
+    std::sort(sorted_ranks.begin(), sorted_ranks.end());
+    sorted_ranks.erase(std::unique(sorted_ranks.begin(), sorted_ranks.end()),
+                       sorted_ranks.end());
+
+    std::mt19937_64 generator(seed);
+    KStatistics::MultiSelect(array.begin(), array.end(), sorted_ranks.data(),
+                             sorted_ranks.data() + sorted_ranks.size(),
+                             std::less<>(), generator);
+
+    // prefix_sums[i] is the sum of array[0, sorted_ranks[i])
+    const auto kSegments = SummarizeSegments(array, sorted_ranks);
+    std::vector<Sum<T>> prefix_sums(kSegments.size());
+    for (size_t index = 0; index < kSegments.size(); ++index) {
+        prefix_sums[index] = (index > 0 ? prefix_sums[index - 1] : 0) +
+                             kSegments[index].sum;
+    }
+    statistics.sum = prefix_sums.back();
+    statistics.mean = static_cast<double>(statistics.sum) / kSize;
+
+    for (size_t index = 0; index < levels.size(); ++index) {
+        const int64_t kRank = ranks[index];
+        const size_t kPosition =
+            std::lower_bound(sorted_ranks.begin(), sorted_ranks.end(), kRank) -
+            sorted_ranks.begin();
+        const T kValue = array[kRank];
+        const auto [kBelowCount, kAboveCount] =
+            CountsAround(array, sorted_ranks, kSegments, kPosition);
+        const Sum<T> kBeforeSum = prefix_sums[kPosition];
+        const Sum<T> kAfterSum = statistics.sum - kBeforeSum - kValue;
+        const Sum<T> kDeviationSum =
+            static_cast<Sum<T>>(kValue) * kRank - kBeforeSum + kAfterSum -
+            static_cast<Sum<T>>(kValue) * (kSize - kRank - 1);
+        statistics.quantiles.push_back(
+            {levels[index], kRank, kValue, kBelowCount, kAboveCount,
+             kDeviationSum, static_cast<double>(kDeviationSum) / kSize});
+    }
+    return statistics;
+}
+
+}  // namespace ArrayStatistics
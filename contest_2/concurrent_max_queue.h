@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include "max_queue.h"
+
+// MaxQueue for one producer thread and any number of reader threads. Only
+// the producer calls PushBack and PopFront and it owns the MaxQueue. After
+// every change it publishes the new maximum and size under a seqlock.
+// Readers never block the producer and never take a lock; a reader retries
+// only if it raced with a publish, which is two relaxed stores long.
+template <typename T>
+class ConcurrentMaxQueue {
+private:
+    static_assert(std::atomic<T>::is_always_lock_free);
+
+    MaxQueue<T> max_queue_;
+
+    // odd while the producer is publishing
+    std::atomic<uint64_t> sequence_ = 0;
+    std::atomic<T> published_max_{};
+    std::atomic<size_t> published_size_ = 0;
+
+    void Publish() {
+        const uint64_t kSequence = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(kSequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        const size_t kSize = max_queue_.Size();
+        published_size_.store(kSize, std::memory_order_relaxed);
+        if (kSize != 0) {
+            published_max_.store(max_queue_.GetMax(),
+                                 std::memory_order_relaxed);
+        }
+
+        sequence_.store(kSequence + 2, std::memory_order_release);
+    }
+
+public:
+    // capacity is the maximal number of samples in the queue at once
+    ConcurrentMaxQueue(int capacity) : max_queue_(capacity) {}
+
+    // producer only
+    void PushBack(T value) {
+        max_queue_.PushBack(value);
+        Publish();
+    }
+
+    // producer only, queue must not be empty
+    void PopFront() {
+        max_queue_.PopFront();
+        Publish();
+    }
+
+    // producer only, pushes value and evicts the oldest samples so that at
+    // most window_size stay in the queue; they are evicted before the push,
+    // so window_size up to the capacity never overflows the queue
+    void PushBackEvicting(T value, size_t window_size) {
+        while (!max_queue_.Empty() && max_queue_.Size() >= window_size) {
+            max_queue_.PopFront();
+        }
+        max_queue_.PushBack(value);
+        if (max_queue_.Size() > window_size) {
+            max_queue_.PopFront();
+        }
+        Publish();
+    }
+
+    // any thread, std::nullopt if the queue is empty
+    std::optional<T> GetMax() const {
+        while (true) {
+            const uint64_t kSequence =
+                sequence_.load(std::memory_order_acquire);
+            if (kSequence % 2 == 1) {
+                continue;
+            }
+            const size_t kSize =
+                published_size_.load(std::memory_order_relaxed);
+            const T kMax = published_max_.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence_.load(std::memory_order_relaxed) == kSequence) {
+                return kSize == 0 ? std::nullopt : std::optional<T>(kMax);
+            }
+        }
+    }
+
+    // any thread
+    size_t Size() const {
+        return published_size_.load(std::memory_order_acquire);
+    }
+};
@@ -0,0 +1,450 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <numeric>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace CustomSort {
+
+// Pattern-defeating quicksort (pdqsort). Small ranges go to insertion sort,
+// pivots are medians of 3 or ninthers and partitioning is one pass of the
+// branchless BlockQuicksort scheme. Runs of elements equal to the pivot of
+// the parent are split off in O(size) and already partitioned ranges are
+// finished by a bounded insertion sort, so sorted inputs and inputs with
+// few distinct values take linear time. After log2(size) unbalanced
+// partitions the range is heapsorted, so the worst case is O(n log n).
+
+const int kInsertionSortThreshold = 24;
+const int kNintherThreshold = 128;
+const int kPartialInsertionSortLimit = 8;
+const int kBlockSize = 64;
+
+template <typename Iterator, typename Comparator>
+void InsertionSort(Iterator first, Iterator last, Comparator comparator) {
+    if (first == last) {
+        return;
+    }
+    for (Iterator current_it = std::next(first); current_it != last;
+         ++current_it) {
+        auto value = std::move(*current_it);
+        Iterator hole_it = current_it;
+        for (; hole_it != first && comparator(value, *std::prev(hole_it));
+             --hole_it) {
+            *hole_it = std::move(*std::prev(hole_it));
+        }
+        *hole_it = std::move(value);
+    }
+}
+
+// insertion sort that gives up after kPartialInsertionSortLimit moves,
+// returns true if the range got sorted
+template <typename Iterator, typename Comparator>
+bool PartialInsertionSort(Iterator first, Iterator last,
+                          Comparator comparator) {
+    if (first == last) {
+        return true;
+    }
+    int moves_count = 0;
+    for (Iterator current_it = std::next(first); current_it != last;
+         ++current_it) {
+        if (!comparator(*current_it, *std::prev(current_it))) {
+            continue;
+        }
+        auto value = std::move(*current_it);
+        Iterator hole_it = current_it;
+        for (; hole_it != first && comparator(value, *std::prev(hole_it));
+             --hole_it) {
+            *hole_it = std::move(*std::prev(hole_it));
+        }
+        *hole_it = std::move(value);
+        moves_count += current_it - hole_it;
+        if (moves_count > kPartialInsertionSortLimit) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename Iterator, typename Comparator>
+void HeapSort(Iterator first, Iterator last, Comparator comparator) {
+    std::make_heap(first, last, comparator);
+    std::sort_heap(first, last, comparator);
+}
+
+template <typename Iterator, typename Comparator>
+void Sort2(Iterator lhs, Iterator rhs, Comparator comparator) {
+    if (comparator(*rhs, *lhs)) {
+        std::iter_swap(lhs, rhs);
+    }
+}
+
+// puts the median of three to middle
+template <typename Iterator, typename Comparator>
+void Sort3(Iterator first, Iterator middle, Iterator last,
+           Comparator comparator) {
+    Sort2(first, middle, comparator);
+    Sort2(middle, last, comparator);
+    Sort2(first, middle, comparator);
+}
+
+// moves median of 3 or ninther to *first, after that there is an element
+// not less than the pivot in (first, last)
+template <typename Iterator, typename Comparator>
+void SelectPivot(Iterator first, Iterator last, Comparator comparator) {
+    const auto kSize = std::distance(first, last);
+    Iterator middle = first + kSize / 2;
+    if (kSize > kNintherThreshold) {
+        Sort3(first, middle, std::prev(last), comparator);
+        Sort3(first + 1, middle - 1, last - 2, comparator);
+        Sort3(first + 2, middle + 1, last - 3, comparator);
+        Sort3(middle - 1, middle, middle + 1, comparator);
+        std::iter_swap(first, middle);
+    } else {
+        Sort3(middle, first, std::prev(last), comparator);
+    }
+}
+
+// swaps offsets_count pairs of misplaced elements found by PartitionRight
+template <typename Iterator>
+void SwapOffsets(Iterator left_base, Iterator right_base,
+                 const unsigned char* left_offsets,
+                 const unsigned char* right_offsets, int offsets_count) {
+    for (int index = 0; index < offsets_count; ++index) {
+        std::iter_swap(left_base + left_offsets[index],
+                       right_base - right_offsets[index]);
+    }
+}
+
+// BlockQuicksort loop of PartitionRight, on return left_it == right_it is
+// the first element not less than pivot
+template <typename Iterator, typename T, typename Comparator>
+void BlockPartition(Iterator& left_it, Iterator& right_it, const T& pivot,
+                    Comparator comparator) {
+    unsigned char left_offsets[kBlockSize];
+    unsigned char right_offsets[kBlockSize];
+    Iterator left_base = left_it;
+    Iterator right_base = right_it;
+    int left_count = 0;
+    int right_count = 0;
+    int left_start = 0;
+    int right_start = 0;
+
+    while (left_it < right_it) {
+        const auto kUnknown = right_it - left_it;
+        const auto kLeftSplit =
+            left_count == 0 ? (right_count == 0 ? kUnknown / 2 : kUnknown) : 0;
+        const auto kRightSplit = right_count == 0 ? kUnknown - kLeftSplit : 0;
+
+        const int kLeftBlock =
+            std::min<decltype(kUnknown)>(kLeftSplit, kBlockSize);
+        for (int index = 0; index < kLeftBlock; ++index) {
+            left_offsets[left_count] = index;
+            left_count += !comparator(*left_it, pivot);
+            ++left_it;
+        }
+        const int kRightBlock =
+            std::min<decltype(kUnknown)>(kRightSplit, kBlockSize);
+        for (int index = 1; index <= kRightBlock; ++index) {
+            right_offsets[right_count] = index;
+            right_count += comparator(*--right_it, pivot);
+        }
+
+        const int kSwapCount = std::min(left_count, right_count);
+        SwapOffsets(left_base, right_base, left_offsets + left_start,
+                    right_offsets + right_start, kSwapCount);
+        left_count -= kSwapCount;
+        right_count -= kSwapCount;
+        left_start += kSwapCount;
+        right_start += kSwapCount;
+
+        if (left_count == 0) {
+            left_start = 0;
+            left_base = left_it;
+        }
+        if (right_count == 0) {
+            right_start = 0;
+            right_base = right_it;
+        }
+    }
+
+    // one block still has misplaced elements, move them to the border
+    while (left_count > 0) {
+        --left_count;
+        std::iter_swap(left_base + left_offsets[left_start + left_count],
+                       --right_it);
+        left_it = right_it;
+    }
+    while (right_count > 0) {
+        --right_count;
+        std::iter_swap(right_base - right_offsets[right_start + right_count],
+                       left_it);
+        ++left_it;
+        right_it = left_it;
+    }
+}
+
+// Partitions [first, last) around pivot *first into [< pivot] pivot
+// [>= pivot]. Comparisons only fill offset buffers of misplaced elements,
+// so there are no branches that depend on their results.
+// Returns pivot position and whether the range was already partitioned.
+template <typename Iterator, typename Comparator>
+std::pair<Iterator, bool> PartitionRight(Iterator first, Iterator last,
+                                         Comparator comparator) {
+    auto pivot = std::move(*first);
+    Iterator left_it = first;
+    Iterator right_it = last;
+
+    while (comparator(*++left_it, pivot)) {
+    }
+    if (std::prev(left_it) == first) {
+        while (left_it < right_it && !comparator(*--right_it, pivot)) {
+        }
+    } else {
+        while (!comparator(*--right_it, pivot)) {
+        }
+    }
+
+    const bool kAlreadyPartitioned = left_it >= right_it;
+    if (!kAlreadyPartitioned) {
+        std::iter_swap(left_it, right_it);
+        ++left_it;
+        BlockPartition(left_it, right_it, pivot, comparator);
+    }
+
+    Iterator pivot_it = std::prev(left_it);
+    *first = std::move(*pivot_it);
+    *pivot_it = std::move(pivot);
+    return {pivot_it, kAlreadyPartitioned};
+}
+
+// Partitions [first, last) around pivot *first into [<= pivot] [> pivot],
+// used when the pivot equals the element before the range, so the left
+// part is all equal to it. Returns the last position of the left part.
+template <typename Iterator, typename Comparator>
+Iterator PartitionLeft(Iterator first, Iterator last, Comparator comparator) {
+    auto pivot = std::move(*first);
+    Iterator left_it = first;
+    Iterator right_it = last;
+
+    while (comparator(pivot, *--right_it)) {
+    }
+    if (std::next(right_it) == last) {
+        while (left_it < right_it && !comparator(pivot, *++left_it)) {
+        }
+    } else {
+        while (!comparator(pivot, *++left_it)) {
+        }
+    }
+
+    while (left_it < right_it) {
+        std::iter_swap(left_it, right_it);
+        while (comparator(pivot, *--right_it)) {
+        }
+        while (!comparator(pivot, *++left_it)) {
+        }
+    }
+
+    *first = std::move(*right_it);
+    *right_it = std::move(pivot);
+    return right_it;
+}
+
+// swaps a few elements of a badly partitioned part to break patterns
+template <typename Iterator>
+void BreakPatterns(Iterator first, Iterator last) {
+    const auto kSize = std::distance(first, last);
+    if (kSize < kInsertionSortThreshold) {
+        return;
+    }
+    const auto kQuarter = kSize / 4;
+    std::iter_swap(first, first + kQuarter);
+    std::iter_swap(std::prev(last), last - kQuarter);
+    if (kSize > kNintherThreshold) {
+        std::iter_swap(first + 1, first + (kQuarter + 1));
+        std::iter_swap(first + 2, first + (kQuarter + 2));
+        std::iter_swap(last - 2, last - (kQuarter + 1));
+        std::iter_swap(last - 3, last - (kQuarter + 2));
+    }
+}
+
+// leftmost is false if *std::prev(first) is a pivot of a parent range,
+// it is not greater than any element of [first, last)
+template <typename Iterator, typename Comparator>
+void QuickSortLoop(Iterator first, Iterator last, Comparator comparator,
+                   int bad_partitions_allowed, bool leftmost) {
+    while (true) {
+        const auto kSize = std::distance(first, last);
+        if (kSize < kInsertionSortThreshold) {
+            InsertionSort(first, last, comparator);
+            return;
+        }
+
+        SelectPivot(first, last, comparator);
+        if (!leftmost && !comparator(*std::prev(first), *first)) {
+            first = std::next(PartitionLeft(first, last, comparator));
+            continue;
+        }
+
+        auto [pivot_it, already_partitioned] =
+            PartitionRight(first, last, comparator);
+        const auto kLeftSize = std::distance(first, pivot_it);
+        const auto kRightSize = std::distance(pivot_it, last) - 1;
+
+        if (kLeftSize < kSize / 8 || kRightSize < kSize / 8) {
+            if (--bad_partitions_allowed == 0) {
+                HeapSort(first, last, comparator);
+                return;
+            }
+            BreakPatterns(first, pivot_it);
+            BreakPatterns(std::next(pivot_it), last);
+        } else if (already_partitioned &&
+                   PartialInsertionSort(first, pivot_it, comparator) &&
+                   PartialInsertionSort(std::next(pivot_it), last,
+                                        comparator)) {
+            return;
+        }
+
+        QuickSortLoop(first, pivot_it, comparator, bad_partitions_allowed,
+                      leftmost);
+        first = std::next(pivot_it);
+        leftmost = false;
+    }
+}
+
+template <typename Iterator, typename Comparator>
+void QuickSort(Iterator first, Iterator last, Comparator comparator) {
+    const auto kSize = std::distance(first, last);
+    if (kSize <= 1) {
+        return;
+    }
+    const int kBadPartitionsAllowed =
+        std::bit_width(static_cast<uint64_t>(kSize));
+    QuickSortLoop(first, last, comparator, kBadPartitionsAllowed, true);
+}
+
+// LSD radix sort is used by SortByKey for integral and floating point keys
+// of ranges of at least kRadixSortThreshold elements
+template <typename Key>
+inline constexpr bool kIsRadixKey =
+    (std::is_integral_v<Key> && !std::is_same_v<Key, bool>) ||
+    std::is_same_v<Key, float> || std::is_same_v<Key, double>;
+
+const int kRadixSortThreshold = 256;
+
+// unsigned bits of key with the same order as key, -0.0 and +0.0 get the
+// same bits as they are equal, NaN is not allowed
+template <typename Key>
+auto RadixBits(Key key) {
+    if constexpr (std::is_integral_v<Key>) {
+        using Bits = std::make_unsigned_t<Key>;
+        auto bits = static_cast<Bits>(key);
+        if constexpr (std::is_signed_v<Key>) {
+            bits ^= Bits{1} << (8 * sizeof(Bits) - 1);
+        }
+        return bits;
+    } else {
+        using Bits =
+            std::conditional_t<sizeof(Key) == 4, uint32_t, uint64_t>;
+        const auto kBits = std::bit_cast<Bits>(key == Key{0} ? Key{0} : key);
+        const Bits kSignBit = Bits{1} << (8 * sizeof(Bits) - 1);
+        // negative numbers reverse their order, positive go after them
+        return (kBits & kSignBit) != 0 ? static_cast<Bits>(~kBits)
+                                       : static_cast<Bits>(kBits | kSignBit);
+    }
+}
+
+// Stable LSD radix sort by 8-bit digits for short keys and 11-bit digits
+// for 32 and 64-bit ones. All digit histograms are counted in one pass and
+// digits that are equal for every element are skipped. The range is moved
+// into the buffer before the first scatter, so Value only has to be
+// movable like for QuickSort.
+template <typename Iterator, typename KeyExtractor>
+void RadixSortByKey(Iterator first, Iterator last,
+                    KeyExtractor key_extractor) {
+    using Value = typename std::iterator_traits<Iterator>::value_type;
+    using Bits = decltype(RadixBits(key_extractor(*first)));
+    const int kKeyBits = 8 * sizeof(Bits);
+    const int kDigitBits = kKeyBits >= 32 ? 11 : 8;
+    const int kDigitCount = (kKeyBits + kDigitBits - 1) / kDigitBits;
+    const size_t kBucketCount = size_t{1} << kDigitBits;
+    const Bits kDigitMask = kBucketCount - 1;
+
+    const size_t kSize = std::distance(first, last);
+    std::vector<std::array<size_t, kBucketCount>> counts(kDigitCount);
+    for (Iterator current_it = first; current_it != last; ++current_it) {
+        const Bits kBits = RadixBits(key_extractor(*current_it));
+        for (int digit = 0; digit < kDigitCount; ++digit) {
+            ++counts[digit][(kBits >> (digit * kDigitBits)) & kDigitMask];
+        }
+    }
+
+    std::vector<int> scattered_digits;
+    for (int digit = 0; digit < kDigitCount; ++digit) {
+        if (std::find(counts[digit].begin(), counts[digit].end(), kSize) ==
+            counts[digit].end()) {
+            scattered_digits.push_back(digit);
+        }
+    }
+    if (scattered_digits.empty()) {
+        return;
+    }
+
+    std::vector<Value> buffer(std::make_move_iterator(first),
+                              std::make_move_iterator(last));
+    bool in_buffer = true;
+    auto scatter = [&](auto source_first, auto target_first, int digit) {
+        std::array<size_t, kBucketCount> positions;
+        std::exclusive_scan(counts[digit].begin(), counts[digit].end(),
+                            positions.begin(), size_t{0});
+        for (size_t index = 0; index < kSize; ++index) {
+            auto& value = source_first[index];
+            const Bits kBits = RadixBits(key_extractor(value));
+            target_first[positions[(kBits >> (digit * kDigitBits)) &
+                                   kDigitMask]++] = std::move(value);
+        }
+    };
+
+    for (int digit : scattered_digits) {
+        if (in_buffer) {
+            scatter(buffer.begin(), first, digit);
+        } else {
+            scatter(first, buffer.begin(), digit);
+        }
+        in_buffer = !in_buffer;
+    }
+
+    if (in_buffer) {
+        std::move(buffer.begin(), buffer.end(), first);
+    }
+}
+
+// Sorts by key_extractor(element) with operator< of the keys. Integral and
+// floating point keys are sorted stably, by RadixSortByKey or by
+// InsertionSort below kRadixSortThreshold elements; other keys are sorted
+// by QuickSort, which is not stable.
+template <typename Iterator, typename KeyExtractor>
+void SortByKey(Iterator first, Iterator last, KeyExtractor key_extractor) {
+    using Value = typename std::iterator_traits<Iterator>::value_type;
+    using Key = std::decay_t<std::invoke_result_t<KeyExtractor, const Value&>>;
+    auto comparator = [&key_extractor](const Value& lhs, const Value& rhs) {
+        return key_extractor(lhs) < key_extractor(rhs);
+    };
+    if constexpr (kIsRadixKey<Key>) {
+        if (std::distance(first, last) >= kRadixSortThreshold) {
+            RadixSortByKey(first, last, key_extractor);
+        } else {
+            InsertionSort(first, last, comparator);
+        }
+    } else {
+        QuickSort(first, last, comparator);
+    }
+}
+
+}  // namespace CustomSort
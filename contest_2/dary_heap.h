@@ -0,0 +1,299 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Allocator of memory aligned to the cache line size.
+template <typename T>
+struct CacheAlignedAllocator {
+    using value_type = T;
+
+    static constexpr size_t kAlignment = std::max<size_t>(64, alignof(T));
+
+    CacheAlignedAllocator() = default;
+    template <typename U>
+    CacheAlignedAllocator(const CacheAlignedAllocator<U>& /*other*/) {}
+
+    T* allocate(size_t count) {
+        return static_cast<T*>(::operator new(count * sizeof(T),
+                                              std::align_val_t(kAlignment)));
+    }
+
+    void deallocate(T* pointer, size_t /*count*/) {
+        ::operator delete(pointer, std::align_val_t(kAlignment));
+    }
+
+    template <typename U>
+    bool operator==(const CacheAlignedAllocator<U>& /*other*/) const {
+        return true;
+    }
+};
+
+// Heap of the given arity with the smallest element by Compare on top.
+// Element i has children arity * i + 1, ..., arity * i + arity. The
+// elements are stored after arity - 1 padding slots in cache-line-aligned
+// memory, so the children of every element start at a multiple of arity
+// slots: with arity * sizeof(T) = 64 a sift down step reads exactly one
+// cache line. T must be default constructible for the padding.
+//
+// With with_handles every pushed element gets a handle that stays valid
+// until the element leaves the heap, for Get, DecreaseKey, Update and Erase.
+// Without it the heap keeps no bookkeeping besides the elements.
+template <typename T, typename Compare = std::less<T>, int arity = 4,
+          bool with_handles = false>
+class DaryHeap {
+public:
+    using Handle = int;
+
+    static constexpr Handle kNoHandle = -1;
+
+private:
+    static_assert(arity >= 2);
+
+    static constexpr int kPadding = arity - 1;
+    static constexpr int kNotInHeap = -1;
+
+    std::vector<T, CacheAlignedAllocator<T>> slots_;
+    Compare compare_;
+
+    // used with with_handles only
+    std::vector<Handle> handles_;
+    std::vector<int> positions_;
+    std::vector<Handle> free_handles_;
+
+    T& At(int position) { return slots_[kPadding + position]; }
+    const T& At(int position) const { return slots_[kPadding + position]; }
+
+    Handle HandleAt(int position) const {
+        if constexpr (with_handles) {
+            return handles_[position];
+        } else {
+            return kNoHandle;
+        }
+    }
+
+    void Place(int position, T&& value, Handle handle) {
+        At(position) = std::move(value);
+        if constexpr (with_handles) {
+            handles_[position] = handle;
+            positions_[handle] = position;
+        }
+    }
+
+    Handle NewHandle() {
+        if constexpr (with_handles) {
+            if (free_handles_.empty()) {
+                positions_.push_back(kNotInHeap);
+                return positions_.size() - 1;
+            }
+            const Handle kHandle = free_handles_.back();
+            free_handles_.pop_back();
+            return kHandle;
+        } else {
+            return kNoHandle;
+        }
+    }
+
+    void FreeHandle(Handle handle) {
+        if constexpr (with_handles) {
+            positions_[handle] = kNotInHeap;
+            free_handles_.push_back(handle);
+        }
+    }
+
+    // the hole at position goes up until value fits into it
+    void SiftUp(int position, T value, Handle handle) {
+        while (position > 0) {
+            const int kParent = (position - 1) / arity;
+            if (!compare_(value, At(kParent))) {
+                break;
+            }
+            Place(position, std::move(At(kParent)), HandleAt(kParent));
+            position = kParent;
+        }
+        Place(position, std::move(value), handle);
+    }
+
+    // the hole at position goes down until value fits into it
+    void SiftDown(int position, T value, Handle handle) {
+        const int kSize = Size();
+        while (true) {
+            const int kFirstChild = arity * position + 1;
+            if (kFirstChild >= kSize) {
+                break;
+            }
+            const int kLastChild = std::min(kFirstChild + arity, kSize);
+            int best_child = kFirstChild;
+            for (int child = kFirstChild + 1; child < kLastChild; ++child) {
+                if (compare_(At(child), At(best_child))) {
+                    best_child = child;
+                }
+            }
+            if (!compare_(At(best_child), value)) {
+                break;
+            }
+            Place(position, std::move(At(best_child)), HandleAt(best_child));
+            position = best_child;
+        }
+        Place(position, std::move(value), handle);
+    }
+
+    // puts value into the hole at position wherever it has to go
+    void Fix(int position, T value, Handle handle) {
+        if (position > 0 && compare_(value, At((position - 1) / arity))) {
+            SiftUp(position, std::move(value), handle);
+        } else {
+            SiftDown(position, std::move(value), handle);
+        }
+    }
+
+    // removes the last slot, returns its element and handle
+    std::pair<T, Handle> PopLast() {
+        std::pair<T, Handle> last(std::move(slots_.back()),
+                                  HandleAt(Size() - 1));
+        slots_.pop_back();
+        if constexpr (with_handles) {
+            handles_.pop_back();
+        }
+        return last;
+    }
+
+    void AddSlot() {
+        slots_.emplace_back();
+        if constexpr (with_handles) {
+            handles_.push_back(kNoHandle);
+        }
+    }
+
+public:
+    DaryHeap(Compare compare = Compare())
+        : slots_(kPadding), compare_(compare) {}
+
+    // heapifies values in O(n), with handles the handle of values[i] is i
+    DaryHeap(const std::vector<T>& values, Compare compare = Compare())
+        : slots_(kPadding), compare_(compare) {
+        slots_.insert(slots_.end(), values.begin(), values.end());
+        const int kSize = Size();
+        if constexpr (with_handles) {
+            handles_.resize(kSize);
+            positions_.resize(kSize);
+            for (int position = 0; position < kSize; ++position) {
+                handles_[position] = position;
+                positions_[position] = position;
+            }
+        }
+        for (int position = (kSize - 2) / arity; kSize > 1 && position >= 0;
+             --position) {
+            SiftDown(position, std::move(At(position)), HandleAt(position));
+        }
+    }
+
+    int Size() const { return slots_.size() - kPadding; }
+
+    bool Empty() const { return Size() == 0; }
+
+    void Reserve(int capacity) {
+        slots_.reserve(kPadding + capacity);
+        if constexpr (with_handles) {
+            handles_.reserve(capacity);
+            positions_.reserve(capacity);
+        }
+    }
+
+    // the heap must not be empty
+    const T& Top() const {
+        assert(!Empty());
+        return At(0);
+    }
+
+    // the heap must not be empty
+    Handle TopHandle() const {
+        static_assert(with_handles);
+        assert(!Empty());
+        return HandleAt(0);
+    }
+
+    // returns the handle of value, kNoHandle without handles
+    Handle Push(T value) {
+        const Handle kHandle = NewHandle();
+        AddSlot();
+        SiftUp(Size() - 1, std::move(value), kHandle);
+        return kHandle;
+    }
+
+    // the heap must not be empty
+    T Pop() {
+        assert(!Empty());
+        T top = std::move(At(0));
+        FreeHandle(HandleAt(0));
+        auto [last, last_handle] = PopLast();
+        if (!Empty()) {
+            SiftDown(0, std::move(last), last_handle);
+        }
+        return top;
+    }
+
+    // Push(value) followed by Pop() in one sift down, or none at all if
+    // value is not greater than Top()
+    T PushPop(T value) {
+        static_assert(!with_handles, "the pushed value would need a handle");
+        if (Empty() || !compare_(At(0), value)) {
+            return value;
+        }
+        T top = std::move(At(0));
+        SiftDown(0, std::move(value), kNoHandle);
+        return top;
+    }
+
+    // Pop() followed by Push(value) in one sift down, the handle of the old
+    // top moves to value; the heap must not be empty
+    T ReplaceTop(T value) {
+        assert(!Empty());
+        T top = std::move(At(0));
+        SiftDown(0, std::move(value), HandleAt(0));
+        return top;
+    }
+
+    bool Contains(Handle handle) const {
+        static_assert(with_handles);
+        return 0 <= handle && handle < static_cast<int>(positions_.size()) &&
+               positions_[handle] != kNotInHeap;
+    }
+
+    const T& Get(Handle handle) const {
+        static_assert(with_handles);
+        assert(Contains(handle));
+        return At(positions_[handle]);
+    }
+
+    // value must not be greater than the current one
+    void DecreaseKey(Handle handle, T value) {
+        static_assert(with_handles);
+        assert(Contains(handle) && !compare_(Get(handle), value));
+        SiftUp(positions_[handle], std::move(value), handle);
+    }
+
+    void Update(Handle handle, T value) {
+        static_assert(with_handles);
+        assert(Contains(handle));
+        Fix(positions_[handle], std::move(value), handle);
+    }
+
+    T Erase(Handle handle) {
+        static_assert(with_handles);
+        assert(Contains(handle));
+        const int kPosition = positions_[handle];
+        T erased = std::move(At(kPosition));
+        FreeHandle(handle);
+        auto [last, last_handle] = PopLast();
+        if (kPosition < Size()) {
+            Fix(kPosition, std::move(last), last_handle);
+        }
+        return erased;
+    }
+};
@@ -0,0 +1,270 @@
+#pragma once
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "k_way_merge.h"
+
+// K-way merge of sorted runs that do not fit in memory. A run is a binary
+// file of trivially copyable T. Every run is read through its own buffer
+// and the output goes through one more buffer, so peak memory is
+// (k + 1) * buffer_bytes whatever the total size of the runs.
+namespace ExternalMerge {
+
+const size_t kDefaultBufferBytes = 1 << 16;
+
+inline void ThrowSystemError(const std::string& what) {
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+// Owns a file descriptor, so it is closed however the owner's constructor
+// or destructor exits.
+class FileDescriptor {
+private:
+    int descriptor_;
+
+public:
+    FileDescriptor(const std::string& path, int flags, mode_t mode = 0)
+        : descriptor_(open(path.c_str(), flags, mode)) {
+        if (descriptor_ < 0) {
+            ThrowSystemError("open " + path);
+        }
+    }
+
+    FileDescriptor(const FileDescriptor&) = delete;
+    FileDescriptor& operator=(const FileDescriptor&) = delete;
+
+    ~FileDescriptor() {
+        if (descriptor_ >= 0) {
+            close(descriptor_);
+        }
+    }
+
+    int Get() const { return descriptor_; }
+
+    bool IsOpen() const { return descriptor_ >= 0; }
+
+    // returns the result of close(), the descriptor is released either way
+    int Close() {
+        const int kDescriptor = descriptor_;
+        descriptor_ = -1;
+        return close(kDescriptor);
+    }
+};
+
+// Sorted run read chunk by chunk. Right after a refill the kernel is asked
+// to read the following chunk ahead (POSIX_FADV_WILLNEED): the disk works on
+// it while the merge consumes the current chunk, and the next refill copies
+// from the page cache. This gives the overlap of a second buffer without a
+// reader thread per run.
+template <typename T>
+class FileRun {
+private:
+    static_assert(std::is_trivially_copyable_v<T>);
+
+    std::string path_;
+    FileDescriptor descriptor_;
+    std::vector<T> buffer_;
+    size_t position_ = 0;
+    size_t size_ = 0;
+    off_t offset_ = 0;
+
+    void Refill() {
+        const size_t kBytes = buffer_.size() * sizeof(T);
+        auto* data = reinterpret_cast<char*>(buffer_.data());
+        size_t read_bytes = 0;
+        while (read_bytes < kBytes) {
+            const ssize_t kRead = pread(descriptor_.Get(), data + read_bytes,
+                                        kBytes - read_bytes, offset_);
+            if (kRead < 0 && errno == EINTR) {
+                continue;
+            }
+            if (kRead < 0) {
+                ThrowSystemError("read " + path_);
+            }
+            if (kRead == 0) {
+                break;
+            }
+            read_bytes += kRead;
+            offset_ += kRead;
+        }
+        if (read_bytes % sizeof(T) != 0) {
+            throw std::runtime_error("truncated run " + path_);
+        }
+        position_ = 0;
+        size_ = read_bytes / sizeof(T);
+        if (size_ == buffer_.size()) {
+            posix_fadvise(descriptor_.Get(), offset_, kBytes,
+                          POSIX_FADV_WILLNEED);
+        }
+    }
+
+public:
+    // input iterator over the rest of the run, compares equal to the
+    // default constructed end iterator once the run is exhausted
+    class Iterator {
+    private:
+        FileRun* run_ = nullptr;
+
+        bool AtEnd() const { return run_ == nullptr || run_->Empty(); }
+
+    public:
+        Iterator() = default;
+        Iterator(FileRun* run) : run_(run) {}
+
+        const T& operator*() const { return run_->Front(); }
+
+        Iterator& operator++() {
+            run_->Pop();
+            return *this;
+        }
+
+        bool operator==(const Iterator& other) const {
+            return AtEnd() == other.AtEnd();
+        }
+    };
+
+    FileRun(const std::string& path, size_t buffer_bytes = kDefaultBufferBytes)
+        : path_(path),
+          descriptor_(path, O_RDONLY),
+          buffer_(std::max<size_t>(buffer_bytes / sizeof(T), 1)) {
+        posix_fadvise(descriptor_.Get(), 0, 0, POSIX_FADV_SEQUENTIAL);
+        Refill();
+    }
+
+    FileRun(const FileRun&) = delete;
+    FileRun& operator=(const FileRun&) = delete;
+
+    bool Empty() const { return position_ == size_; }
+
+    // the run must not be empty
+    const T& Front() const { return buffer_[position_]; }
+
+    // the run must not be empty
+    void Pop() {
+        if (++position_ == size_) {
+            Refill();
+        }
+    }
+
+    Iterator begin() { return Iterator(this); }
+    Iterator end() { return Iterator(); }
+};
+
+// Buffered writer of T values to a binary file, the file is truncated.
+// Close reports every write error, including the delayed ones that only
+// show up on close such as ENOSPC; the destructor flushes too but has to
+// swallow errors.
+template <typename T>
+class FileWriter {
+private:
+    static_assert(std::is_trivially_copyable_v<T>);
+
+    std::string path_;
+    FileDescriptor descriptor_;
+    std::vector<T> buffer_;
+    size_t size_ = 0;
+
+public:
+    FileWriter(const std::string& path,
+               size_t buffer_bytes = kDefaultBufferBytes)
+        : path_(path),
+          descriptor_(path, O_WRONLY | O_CREAT | O_TRUNC, 0644),
+          buffer_(std::max<size_t>(buffer_bytes / sizeof(T), 1)) {}
+
+    FileWriter(const FileWriter&) = delete;
+    FileWriter& operator=(const FileWriter&) = delete;
+
+    ~FileWriter() {
+        if (!descriptor_.IsOpen()) {
+            return;
+        }
+        try {
+            Flush();
+        } catch (const std::system_error&) {
+        }
+    }
+
+    void Write(const T& value) {
+        buffer_[size_++] = value;
+        if (size_ == buffer_.size()) {
+            Flush();
+        }
+    }
+
+    void Flush() {
+        const auto* data = reinterpret_cast<const char*>(buffer_.data());
+        const size_t kBytes = size_ * sizeof(T);
+        size_t written_bytes = 0;
+        while (written_bytes < kBytes) {
+            const ssize_t kWritten =
+                write(descriptor_.Get(), data + written_bytes,
+                      kBytes - written_bytes);
+            if (kWritten < 0 && errno == EINTR) {
+                continue;
+            }
+            if (kWritten < 0) {
+                ThrowSystemError("write " + path_);
+            }
+            written_bytes += kWritten;
+        }
+        size_ = 0;
+    }
+
+    // flushes and closes the file, the writer must not be used after it
+    void Close() {
+        Flush();
+        if (descriptor_.Close() != 0) {
+            ThrowSystemError("close " + path_);
+        }
+    }
+};
+
+// Merges sorted runs stored at run_paths, calls output for every element in
+// sorted order as soon as it is known.
+template <typename T, typename Output, typename Compare = std::less<>>
+void ForEachMerged(const std::vector<std::string>& run_paths, Output output,
+                   size_t buffer_bytes = kDefaultBufferBytes,
+                   Compare compare = Compare()) {
+    using Iterator = typename FileRun<T>::Iterator;
+    std::vector<std::unique_ptr<FileRun<T>>> runs;
+    std::vector<std::pair<Iterator, Iterator>> cursors;
+    runs.reserve(run_paths.size());
+    for (const auto& path : run_paths) {
+        runs.push_back(std::make_unique<FileRun<T>>(path, buffer_bytes));
+        cursors.emplace_back(runs.back()->begin(), runs.back()->end());
+    }
+
+    LoserTree<Iterator, Compare> tree(cursors, compare);
+    while (!tree.Empty()) {
+        output(tree.Top());
+        tree.Pop();
+    }
+}
+
+// Merges sorted runs stored at run_paths into the file at output_path.
+template <typename T, typename Compare = std::less<>>
+void MergeFiles(const std::vector<std::string>& run_paths,
+                const std::string& output_path,
+                size_t buffer_bytes = kDefaultBufferBytes,
+                Compare compare = Compare()) {
+    FileWriter<T> writer(output_path, buffer_bytes);
+    ForEachMerged<T>(
+        run_paths, [&writer](const T& value) { writer.Write(value); },
+        buffer_bytes, compare);
+    writer.Close();
+}
+
+}  // namespace ExternalMerge
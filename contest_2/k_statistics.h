@@ -0,0 +1,199 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "custom_sort.h"
+
+// Introselect: puts the element of rank nth into place like
+// std::nth_element, in worst case O(n) time.
+//
+// Large ranges take the pivot by Floyd-Rivest sampling: about n^(2/3)
+// random elements are moved to a window around nth and the window is
+// selected recursively, so the pivot lands right next to the wanted rank
+// and a random input needs about n + o(n) comparisons. Small ranges use
+// the median of 3 or ninther of CustomSort. Partitioning is the branchless
+// block partition of CustomSort, and runs of elements equal to the
+// previous pivot are split off at once, so few distinct values are cheap.
+//
+// Every partition spends its size from a budget of kWorkFactor * n. Once
+// the budget is gone, which never happens on sane inputs, pivots become
+// medians of medians of 5, which bounds the rest of the work by O(n). The
+// sampling generator is seeded explicitly, so runs are reproducible.
+namespace KStatistics {
+
+const int kFloydRivestThreshold = 600;
+const int kWorkFactor = 8;
+const uint64_t kDefaultSeed = 667;
+
+template <typename Iterator, typename Comparator>
+void Select(Iterator first, Iterator nth, Iterator last, Comparator comparator,
+            std::mt19937_64& generator, int64_t& work_left);
+
+// partitions [first, last) around pivot *first into [< pivot] pivot
+// [>= pivot], returns the pivot position
+template <typename Iterator, typename Comparator>
+Iterator Partition(Iterator first, Iterator last, Comparator comparator) {
+    auto pivot = std::move(*first);
+    Iterator left_it = std::next(first);
+    Iterator right_it = last;
+    CustomSort::BlockPartition(left_it, right_it, pivot, comparator);
+
+    Iterator pivot_it = std::prev(left_it);
+    *first = std::move(*pivot_it);
+    *pivot_it = std::move(pivot);
+    return pivot_it;
+}
+
+// moves to *first a pivot close to the element of rank nth
+template <typename Iterator, typename Comparator>
+void FloydRivestPivot(Iterator first, Iterator nth, Iterator last,
+                      Comparator comparator, std::mt19937_64& generator,
+                      int64_t& work_left) {
+    const int64_t kSize = std::distance(first, last);
+    const int64_t kRank = std::distance(first, nth);
+    const double kLogSize = std::log(static_cast<double>(kSize));
+    const double kSampleSize = 0.5 * std::exp(2 * kLogSize / 3);
+    const double kShift =
+        0.5 *
+        std::sqrt(kLogSize * kSampleSize * (kSize - kSampleSize) / kSize) *
+        (2 * kRank < kSize ? -1 : 1);
+
+    const int64_t kWindowFirst = std::clamp<int64_t>(
+        kRank - kRank * kSampleSize / kSize + kShift, 0, kRank);
+    const int64_t kWindowLast = std::clamp<int64_t>(
+        kRank + (kSize - kRank) * kSampleSize / kSize + kShift + 1, kRank + 1,
+        kSize);
+
+    std::uniform_int_distribution<int64_t> position(0, kSize - 1);
+    for (int64_t index = kWindowFirst; index < kWindowLast; ++index) {
+        std::iter_swap(first + index, first + position(generator));
+    }
+    Select(first + kWindowFirst, nth, first + kWindowLast, comparator,
+           generator, work_left);
+    std::iter_swap(first, nth);
+}
+
+// moves to *first the median of medians of groups of 5, at least 3/10 of
+// the range is not less and 3/10 is not greater than it
+template <typename Iterator, typename Comparator>
+void MedianOfMediansPivot(Iterator first, Iterator last,
+                          Comparator comparator, std::mt19937_64& generator,
+                          int64_t& work_left) {
+    const int64_t kGroupSize = 5;
+    const int64_t kGroupCount = std::distance(first, last) / kGroupSize;
+    for (int64_t group = 0; group < kGroupCount; ++group) {
+        Iterator group_first = first + group * kGroupSize;
+        CustomSort::InsertionSort(group_first, group_first + kGroupSize,
+                                  comparator);
+        std::iter_swap(first + group, group_first + kGroupSize / 2);
+    }
+    Iterator median = first + kGroupCount / 2;
+    Select(first, median, first + kGroupCount, comparator, generator,
+           work_left);
+    std::iter_swap(first, median);
+}
+
+template <typename Iterator, typename Comparator>
+void Select(Iterator first, Iterator nth, Iterator last, Comparator comparator,
+            std::mt19937_64& generator, int64_t& work_left) {
+    // if false, *std::prev(first) is a pivot not greater than [first, last)
+    bool leftmost = true;
+    while (true) {
+        const auto kSize = std::distance(first, last);
+        if (kSize < CustomSort::kInsertionSortThreshold) {
+            CustomSort::InsertionSort(first, last, comparator);
+            return;
+        }
+
+        if (work_left < 0) {
+            MedianOfMediansPivot(first, last, comparator, generator,
+                                 work_left);
+        } else if (kSize > kFloydRivestThreshold) {
+            FloydRivestPivot(first, nth, last, comparator, generator,
+                             work_left);
+        } else {
+            CustomSort::SelectPivot(first, last, comparator);
+        }
+        work_left -= kSize;
+
+        if (!leftmost && !comparator(*std::prev(first), *first)) {
+            Iterator equal_last =
+                std::next(CustomSort::PartitionLeft(first, last, comparator));
+            if (nth < equal_last) {
+                return;
+            }
+            first = equal_last;
+            continue;
+        }
+
+        Iterator pivot_it = Partition(first, last, comparator);
+        if (nth == pivot_it) {
+            return;
+        }
+        if (nth < pivot_it) {
+            last = pivot_it;
+        } else {
+            first = std::next(pivot_it);
+            leftmost = false;
+        }
+    }
+}
+
+template <typename Iterator, typename Comparator>
+void NthElement(Iterator first, Iterator nth, Iterator last,
+                Comparator comparator, uint64_t seed = kDefaultSeed) {
+    if (nth == last) {
+        return;
+    }
+    std::mt19937_64 generator(seed);
+    int64_t work_left = kWorkFactor * std::distance(first, last);
+    Select(first, nth, last, comparator, generator, work_left);
+}
+
+// puts the elements of all ranks into place, ranks are sorted positions
+// and offset is the position of first; the middle rank splits the range and
+// the halves are selected recursively, so every partition serves all ranks
+// inside it: O(n log(rank count)) in total
+template <typename Iterator, typename Comparator>
+void MultiSelect(Iterator first, Iterator last, const int64_t* ranks_first,
+                 const int64_t* ranks_last, Comparator comparator,
+                 std::mt19937_64& generator, int64_t offset = 0) {
+    if (ranks_first == ranks_last) {
+        return;
+    }
+    const int64_t* middle_rank = ranks_first + (ranks_last - ranks_first) / 2;
+    Iterator nth = first + (*middle_rank - offset);
+    int64_t work_left = kWorkFactor * std::distance(first, last);
+    Select(first, nth, last, comparator, generator, work_left);
+
+    // equal ranks are served by nth itself
+    const int64_t* left_last = std::lower_bound(ranks_first, middle_rank,
+                                                *middle_rank);
+    const int64_t* right_first =
+        std::upper_bound(middle_rank, ranks_last, *middle_rank);
+    MultiSelect(first, nth, ranks_first, left_last, comparator, generator,
+                offset);
+    MultiSelect(std::next(nth), last, right_first, ranks_last, comparator,
+                generator, *middle_rank + 1);
+}
+
+}  // namespace KStatistics
+
+// element of rank current_k in [left_index, right_index) of array, which
+// is reordered like by std::nth_element
+template <typename T>
+T GetKStatistics(std::vector<T>& array, int left_index, int right_index,
+                 int current_k, uint64_t seed = KStatistics::kDefaultSeed) {
+    assert(left_index <= current_k && current_k < right_index);
+    KStatistics::NthElement(array.begin() + left_index,
+                            array.begin() + current_k,
+                            array.begin() + right_index, std::less<>(), seed);
+    return array[current_k];
+}
@@ -0,0 +1,233 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <ranges>
+#include <utility>
+#include <vector>
+
+#include "dary_heap.h"
+
+// Tournament tree of losers over k sorted runs [first, last). Leaf i is
+// node k + i, internal node v keeps the run that lost the match played at
+// v, node 0 keeps the overall winner. Taking the winner replays only its
+// leaf-to-root path, which is at most ceil(log2 k) comparisons. An
+// exhausted run loses every match, so no sentinel values are needed. Ties
+// go to the run with the smaller index, so the merge is stable.
+template <typename Iterator, typename Compare = std::less<>>
+class LoserTree {
+private:
+    struct Run {
+        Iterator current;
+        Iterator last;
+    };
+
+    std::vector<Run> runs_;
+    std::vector<int> losers_;
+    Compare compare_;
+
+    bool Exhausted(int run) const {
+        return runs_[run].current == runs_[run].last;
+    }
+
+    // whether run lhs beats run rhs, equivalent elements by run index
+    bool Beats(int lhs, int rhs) const {
+        if (Exhausted(lhs)) {
+            return false;
+        }
+        if (Exhausted(rhs)) {
+            return true;
+        }
+        const auto& lhs_value = *runs_[lhs].current;
+        const auto& rhs_value = *runs_[rhs].current;
+        if (compare_(lhs_value, rhs_value)) {
+            return true;
+        }
+        return !compare_(rhs_value, lhs_value) && lhs < rhs;
+    }
+
+    void Build() {
+        const int kRunCount = runs_.size();
+        std::vector<int> winners(2 * kRunCount);
+        for (int run = 0; run < kRunCount; ++run) {
+            winners[kRunCount + run] = run;
+        }
+        for (int node = kRunCount - 1; node >= 1; --node) {
+            int winner = winners[2 * node];
+            int loser = winners[2 * node + 1];
+            if (Beats(loser, winner)) {
+                std::swap(winner, loser);
+            }
+            winners[node] = winner;
+            losers_[node] = loser;
+        }
+        losers_[0] = kRunCount > 1 ? winners[1] : 0;
+    }
+
+    void Replay(int winner) {
+        const int kRunCount = runs_.size();
+        for (int node = (kRunCount + winner) / 2; node >= 1; node /= 2) {
+            if (Beats(losers_[node], winner)) {
+                std::swap(losers_[node], winner);
+            }
+        }
+        losers_[0] = winner;
+    }
+
+public:
+    LoserTree(const std::vector<std::pair<Iterator, Iterator>>& runs,
+              Compare compare = Compare())
+        : losers_(std::max<size_t>(runs.size(), 1)), compare_(compare) {
+        runs_.reserve(runs.size());
+        for (const auto& [first, last] : runs) {
+            runs_.push_back({first, last});
+        }
+        Build();
+    }
+
+    bool Empty() const { return runs_.empty() || Exhausted(losers_[0]); }
+
+    // smallest current element, the tree must not be empty
+    decltype(auto) Top() const { return *runs_[losers_[0]].current; }
+
+    // run of Top()
+    int TopRun() const { return losers_[0]; }
+
+    // moves past Top(), the tree must not be empty
+    void Pop() {
+        ++runs_[losers_[0]].current;
+        Replay(losers_[0]);
+    }
+};
+
+// Cursors [begin, end) of runs, any container of containers, spans or
+// other sorted ranges.
+template <typename Runs>
+auto RunCursors(const Runs& runs) {
+    using Iterator = decltype(std::begin(*std::begin(runs)));
+    std::vector<std::pair<Iterator, Iterator>> cursors;
+    for (const auto& run : runs) {
+        cursors.emplace_back(std::begin(run), std::end(run));
+    }
+    return cursors;
+}
+
+// Merges sorted runs into out, returns the end of the output.
+template <typename Runs, typename OutputIterator,
+          typename Compare = std::less<>>
+OutputIterator KWayMerge(const Runs& runs, OutputIterator out,
+                         Compare compare = Compare()) {
+    LoserTree tree(RunCursors(runs), compare);
+    while (!tree.Empty()) {
+        *out++ = tree.Top();
+        tree.Pop();
+    }
+    return out;
+}
+
+// KWayMerge with a DaryHeap of the run cursors instead of the LoserTree.
+// Taking an element is one ReplaceTop, a sift down of log_arity(k) levels
+// with up to arity comparisons each, where the LoserTree needs one
+// comparison on each of log2(k) levels. Ties go to the run with the
+// smaller index, so the output is the sequence of KWayMerge.
+template <int arity = 4, typename Runs, typename OutputIterator,
+          typename Compare = std::less<>>
+OutputIterator HeapKWayMerge(const Runs& runs, OutputIterator out,
+                             Compare compare = Compare()) {
+    using Iterator = decltype(std::begin(*std::begin(runs)));
+    struct Cursor {
+        Iterator current;
+        Iterator last;
+        int run;
+    };
+    auto cursor_less = [compare](const Cursor& lhs, const Cursor& rhs) {
+        if (compare(*lhs.current, *rhs.current)) {
+            return true;
+        }
+        return !compare(*rhs.current, *lhs.current) && lhs.run < rhs.run;
+    };
+
+    std::vector<Cursor> cursors;
+    int run = 0;
+    for (const auto& [first, last] : RunCursors(runs)) {
+        if (first != last) {
+            cursors.push_back({first, last, run});
+        }
+        ++run;
+    }
+    DaryHeap<Cursor, decltype(cursor_less), arity> heap(cursors,
+                                                        cursor_less);
+    while (!heap.Empty()) {
+        Cursor top = heap.Top();
+        *out++ = *top.current;
+        if (++top.current == top.last) {
+            heap.Pop();
+        } else {
+            heap.ReplaceTop(top);
+        }
+    }
+    return out;
+}
+
+// Merge of sorted runs as a lazy input range: the next element is found
+// only when the iterator is advanced, so the first K elements cost
+// O(k + K log k) and stopping early costs nothing. It composes with
+// std::views::take, std::views::take_while and the rest of <ranges>:
+//
+//   for (int value : LazyMerge(runs) | std::views::take(100)) { ... }
+template <typename Iterator, typename Compare = std::less<>>
+class MergedView
+    : public std::ranges::view_interface<MergedView<Iterator, Compare>> {
+private:
+    // on the heap so that iterators stay valid when the view is moved
+    std::unique_ptr<LoserTree<Iterator, Compare>> tree_;
+
+public:
+    class MergedIterator {
+    private:
+        LoserTree<Iterator, Compare>* tree_ = nullptr;
+
+    public:
+        using value_type = std::iter_value_t<Iterator>;
+        using difference_type = std::ptrdiff_t;
+
+        MergedIterator() = default;
+        explicit MergedIterator(LoserTree<Iterator, Compare>* tree)
+            : tree_(tree) {}
+
+        decltype(auto) operator*() const { return tree_->Top(); }
+
+        MergedIterator& operator++() {
+            tree_->Pop();
+            return *this;
+        }
+
+        void operator++(int) { tree_->Pop(); }
+
+        bool operator==(std::default_sentinel_t /*end*/) const {
+            return tree_->Empty();
+        }
+    };
+
+    MergedView(const std::vector<std::pair<Iterator, Iterator>>& runs,
+               Compare compare = Compare())
+        : tree_(std::make_unique<LoserTree<Iterator, Compare>>(runs,
+                                                               compare)) {}
+
+    MergedIterator begin() const { return MergedIterator(tree_.get()); }
+
+    std::default_sentinel_t end() const { return std::default_sentinel; }
+};
+
+// the view refers to runs, which must outlive it
+template <typename Runs, typename Compare = std::less<>>
+auto LazyMerge(const Runs& runs, Compare compare = Compare()) {
+    return MergedView(RunCursors(runs), compare);
+}
+
+// a temporary would be destroyed while the view still reads it
+template <typename Runs, typename Compare = std::less<>>
+void LazyMerge(const Runs&& runs, Compare compare = Compare()) = delete;
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <thread>
+#include <vector>
+
+// Linear congruential generator of contest_2/D.cpp. A step is the affine
+// map x -> a * x + b modulo 2^32, and maps compose into maps of the same
+// form, so n steps are one map found by binary exponentiation: JumpAhead
+// takes O(log n). Fill uses that to start every thread and every lane of
+// a thread at its own position, which turns one long dependency chain into
+// independent ones the compiler vectorizes. The values are exactly the
+// ones of repeated NextRand32 calls.
+class Generator {
+private:
+    unsigned int a_, b_;
+    unsigned int cur_ = 0;
+
+    static const unsigned int kEight = 8;
+    static const int kLanes = 16;
+    static const size_t kMinThreadChunk = 1 << 16;
+
+    // x -> multiplier * x + increment
+    struct AffineMap {
+        unsigned int multiplier;
+        unsigned int increment;
+
+        unsigned int operator()(unsigned int x) const {
+            return multiplier * x + increment;
+        }
+
+        // this map applied after other
+        AffineMap After(const AffineMap& other) const {
+            return {multiplier * other.multiplier,
+                    multiplier * other.increment + increment};
+        }
+    };
+
+    static AffineMap Power(AffineMap map, uint64_t exponent) {
+        AffineMap result{1, 0};
+        for (; exponent != 0; exponent >>= 1) {
+            if ((exponent & 1) != 0) {
+                result = map.After(result);
+            }
+            map = map.After(map);
+        }
+        return result;
+    }
+
+    unsigned int NextRand24() {
+        cur_ = cur_ * a_ + b_;  // вычисляется с переполнениями
+        return cur_ >> kEight;  // число от 0 до 2**24-1.
+    }
+
+    static unsigned int Combine(unsigned int first_state,
+                                unsigned int second_state) {
+        return ((first_state >> kEight) << kEight) ^ (second_state >> kEight);
+    }
+
+    // single thread Fill, lane l makes values l, l + kLanes, ...
+    void FillLanes(std::span<int64_t> out) {
+        const size_t kRounds = out.size() / kLanes;
+        if (kRounds > 0) {
+            const AffineMap kStep{a_, b_};
+            const AffineMap kLaneJump = Power(kStep, 2 * kLanes);
+            unsigned int states[kLanes];
+            states[0] = cur_;
+            for (int lane = 1; lane < kLanes; ++lane) {
+                states[lane] = Power(kStep, 2)(states[lane - 1]);
+            }
+            for (size_t round = 0; round < kRounds; ++round) {
+                int64_t* round_out = out.data() + round * kLanes;
+                for (int lane = 0; lane < kLanes; ++lane) {
+                    const unsigned int kFirst = kStep(states[lane]);
+                    const unsigned int kSecond = kStep(kFirst);
+                    round_out[lane] = Combine(kFirst, kSecond);
+                    states[lane] = kLaneJump(states[lane]);
+                }
+            }
+            cur_ = states[0];
+        }
+        for (size_t index = kRounds * kLanes; index < out.size(); ++index) {
+            out[index] = NextRand32();
+        }
+    }
+
+public:
+    Generator(unsigned int current_a, unsigned int current_b)
+        : a_(current_a), b_(current_b) {}
+
+    unsigned int NextRand32() {
+        unsigned int current_a = NextRand24();
+        unsigned int current_b = NextRand24();
+        return (current_a << kEight) ^ current_b;  // число от 0 до 2**32-1.
+    }
+
+    // skips count NextRand32 values
+    void JumpAhead(uint64_t count) { cur_ = Power({a_, b_}, 2 * count)(cur_); }
+
+    // out[i] = i-th next NextRand32 value, on thread_count threads
+    void Fill(std::span<int64_t> out, int thread_count = 1) {
+        const size_t kSize = out.size();
+        if (thread_count <= 1 || kSize < kMinThreadChunk * thread_count) {
+            FillLanes(out);
+            return;
+        }
+        std::vector<std::thread> threads;
+        for (int thread = 0; thread < thread_count; ++thread) {
+            const size_t kFirst = kSize * thread / thread_count;
+            const size_t kLast = kSize * (thread + 1) / thread_count;
+            threads.emplace_back([*this, out, kFirst, kLast]() mutable {
+                JumpAhead(kFirst);
+                FillLanes(out.subspan(kFirst, kLast - kFirst));
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        JumpAhead(kSize);
+    }
+};
@@ -0,0 +1,94 @@
+// Checks Generator::Fill and JumpAhead against repeated NextRand32 calls
+// and benchmarks Fill against the NextRand32 loop.
+//
+//   lcg_generator_bench [size]    values per timed fill, 10^8 by default
+//
+// Every check draws a, b, a number of values to skip, a size and a thread
+// count, and compares the filled values and the generator state after the
+// fill with the ones of a plain NextRand32 loop.
+
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "lcg_generator.h"
+
+namespace {
+
+const int kRandomState = 667;
+const int kCheckCount = 200;
+const int kMaxSkip = 1000;
+const int kMaxCheckSize = 1 << 19;
+const int kMaxThreadCount = 8;
+
+using Clock = std::chrono::steady_clock;
+
+bool FillMatchesLoop(std::mt19937& random) {
+    const unsigned int kA = random();
+    const unsigned int kB = random();
+    const int kSkip = std::uniform_int_distribution(0, kMaxSkip)(random);
+    const int kSize = std::uniform_int_distribution(0, kMaxCheckSize)(random);
+    const int kThreadCount =
+        std::uniform_int_distribution(1, kMaxThreadCount)(random);
+
+    Generator loop_generator(kA, kB);
+    for (int index = 0; index < kSkip; ++index) {
+        loop_generator.NextRand32();
+    }
+    std::vector<int64_t> expected(kSize);
+    for (auto& value : expected) {
+        value = loop_generator.NextRand32();
+    }
+
+    Generator fill_generator(kA, kB);
+    fill_generator.JumpAhead(kSkip);
+    std::vector<int64_t> filled(kSize);
+    fill_generator.Fill(filled, kThreadCount);
+
+    return filled == expected &&
+           fill_generator.NextRand32() == loop_generator.NextRand32();
+}
+
+double Seconds(Clock::duration time) {
+    return std::chrono::duration<double>(time).count();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const int64_t kDefaultSize = 100'000'000;
+    const int64_t kSize = argc > 1 ? std::stoll(argv[1]) : kDefaultSize;
+
+    std::mt19937 random(kRandomState);
+    int failed_count = 0;
+    for (int check = 0; check < kCheckCount; ++check) {
+        failed_count += !FillMatchesLoop(random);
+    }
+    std::cout << "checks: " << kCheckCount - failed_count << " of "
+              << kCheckCount << " match NextRand32\n";
+
+    std::vector<int64_t> values(kSize);
+    Generator loop_generator(random(), random());
+    const auto kLoopStart = Clock::now();
+    for (auto& value : values) {
+        value = loop_generator.NextRand32();
+    }
+    std::cout << std::fixed << std::setprecision(3)
+              << "NextRand32 loop: " << Seconds(Clock::now() - kLoopStart)
+              << " s\n";
+
+    for (int thread_count = 1; thread_count <= kMaxThreadCount;
+         thread_count *= 2) {
+        Generator fill_generator(random(), random());
+        const auto kStart = Clock::now();
+        fill_generator.Fill(values, thread_count);
+        std::cout << "Fill x" << thread_count << ": "
+                  << Seconds(Clock::now() - kStart) << " s\n";
+    }
+
+    return failed_count == 0 ? 0 : 1;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+// Monotonic deque in a fixed-capacity ring buffer. Kept values decrease from
+// head to tail, so the maximum is always the head and every value is pushed
+// and popped at most once. Nothing is allocated after construction.
+template <typename T>
+class MaxQueue {
+private:
+    struct Entry {
+        T value;
+        // number of the PushBack that added the value
+        size_t position;
+    };
+
+    std::vector<Entry> ring_;
+    size_t mask_;
+    // kept entries are [head_, tail_), indices are taken modulo ring size
+    size_t head_ = 0;
+    size_t tail_ = 0;
+    size_t pushed_count_ = 0;
+    size_t popped_count_ = 0;
+
+public:
+    // capacity is the maximal number of elements in the queue at once
+    MaxQueue(int capacity)
+        : ring_(std::bit_ceil(static_cast<size_t>(capacity))),
+          mask_(ring_.size() - 1) {}
+
+    bool Empty() const { return pushed_count_ == popped_count_; }
+
+    size_t Size() const { return pushed_count_ - popped_count_; }
+
+    // queue must have less than capacity elements
+    void PushBack(T value) {
+        assert(Size() < ring_.size());
+        while (tail_ != head_ && ring_[(tail_ - 1) & mask_].value <= value) {
+            --tail_;
+        }
+        ring_[tail_ & mask_] = {value, pushed_count_};
+        ++tail_;
+        ++pushed_count_;
+    }
+
+    void PopFront() {
+        if (ring_[head_ & mask_].position == popped_count_) {
+            ++head_;
+        }
+        ++popped_count_;
+    }
+
+    // queue must not be empty
+    T GetMax() const { return ring_[head_ & mask_].value; }
+};
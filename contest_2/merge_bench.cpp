@@ -0,0 +1,240 @@
+// Benchmarks the merges of contest_2 and checks every merged sequence
+// against std::sort of the same values.
+//
+//   merge_bench [total_size]    elements per merge, 4'000'000 by default
+//
+// External merges k sorted runs of int64_t written to a temporary
+// directory with ExternalMerge::MergeFiles for several k and buffer sizes.
+// It also opens a truncated run, which must throw, and checks that no file
+// descriptor is left open afterwards.
+//
+// InMemory merges runs of records with few distinct keys by the serial
+// KWayMerge, by HeapKWayMerge with DaryHeap of arity 2, 4 and 8, and by the
+// parallel KWayMerge on 1 to kMaxThreadCount threads. Every output must be
+// the serial one record for record, and the serial one must equal
+// std::stable_sort by key.
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "external_merge.h"
+#include "k_way_merge.h"
+#include "parallel_merge.h"
+
+namespace {
+
+const int kRandomState = 667;
+
+using Clock = std::chrono::steady_clock;
+
+// count sorted runs of random values, sizes differ by at most one
+std::vector<std::vector<int64_t>> SortedRuns(int64_t total_size, int count) {
+    std::mt19937_64 generator(kRandomState);
+    std::vector<std::vector<int64_t>> runs(count);
+    for (int run = 0; run < count; ++run) {
+        runs[run].resize(total_size / count + (run < total_size % count));
+        for (auto& value : runs[run]) {
+            value = generator() >> 1;
+        }
+        std::sort(runs[run].begin(), runs[run].end());
+    }
+    return runs;
+}
+
+std::vector<int64_t> SortedConcatenation(
+    const std::vector<std::vector<int64_t>>& runs) {
+    std::vector<int64_t> values;
+    for (const auto& run : runs) {
+        values.insert(values.end(), run.begin(), run.end());
+    }
+    std::sort(values.begin(), values.end());
+    return values;
+}
+
+void PrintResult(const std::string& name, const std::string& setting,
+                 int64_t size, Clock::duration time, bool is_correct) {
+    std::cout << std::setw(10) << name << std::setw(24) << setting
+              << std::setw(10) << std::fixed << std::setprecision(2)
+              << std::chrono::duration<double, std::nano>(time).count() /
+                     size
+              << (is_correct ? "" : "  WRONG") << '\n';
+}
+
+}  // namespace
+
+namespace External {
+
+namespace fs = std::filesystem;
+
+const int kRunCounts[] = {2, 16, 256};
+const size_t kBufferBytes[] = {1 << 12, ExternalMerge::kDefaultBufferBytes};
+
+void WriteRun(const fs::path& path, const std::vector<int64_t>& run) {
+    std::ofstream out(path, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(run.data()),
+              run.size() * sizeof(int64_t));
+}
+
+std::vector<int64_t> ReadRun(const fs::path& path) {
+    std::vector<int64_t> run(fs::file_size(path) / sizeof(int64_t));
+    std::ifstream in(path, std::ios::binary);
+    in.read(reinterpret_cast<char*>(run.data()), run.size() * sizeof(int64_t));
+    return run;
+}
+
+int OpenDescriptorCount() {
+    return std::distance(fs::directory_iterator("/proc/self/fd"),
+                         fs::directory_iterator());
+}
+
+// a run whose size is not a multiple of sizeof(int64_t) must throw and
+// leave no descriptor open
+bool TruncatedRunThrows(const fs::path& directory) {
+    const fs::path kPath = directory / "truncated";
+    std::ofstream(kPath, std::ios::binary) << "12345";
+    const int kDescriptorsBefore = OpenDescriptorCount();
+    bool has_thrown = false;
+    try {
+        ExternalMerge::FileRun<int64_t> run(kPath.string());
+    } catch (const std::runtime_error&) {
+        has_thrown = true;
+    }
+    return has_thrown && OpenDescriptorCount() == kDescriptorsBefore;
+}
+
+void Run(int64_t total_size) {
+    const fs::path kDirectory = fs::temp_directory_path() /
+                                ("merge_bench_" + std::to_string(getpid()));
+    fs::create_directories(kDirectory);
+
+    for (int run_count : kRunCounts) {
+        const auto kRuns = SortedRuns(total_size, run_count);
+        const auto kExpected = SortedConcatenation(kRuns);
+        std::vector<std::string> run_paths;
+        for (int run = 0; run < run_count; ++run) {
+            run_paths.push_back(kDirectory / ("run" + std::to_string(run)));
+            WriteRun(run_paths.back(), kRuns[run]);
+        }
+        const std::string kOutputPath = kDirectory / "merged";
+
+        for (size_t buffer_bytes : kBufferBytes) {
+            const auto kStart = Clock::now();
+            ExternalMerge::MergeFiles<int64_t>(run_paths, kOutputPath,
+                                               buffer_bytes);
+            const auto kTime = Clock::now() - kStart;
+            PrintResult("external",
+                        "k=" + std::to_string(run_count) +
+                            " buffer=" + std::to_string(buffer_bytes),
+                        total_size, kTime, ReadRun(kOutputPath) == kExpected);
+        }
+    }
+
+    std::cout << "truncated run: "
+              << (TruncatedRunThrows(kDirectory) ? "throws, no leak"
+                                                 : "FAILED")
+              << '\n';
+    fs::remove_all(kDirectory);
+}
+
+}  // namespace External
+
+namespace InMemory {
+
+const int kRunCounts[] = {2, 16, 256};
+const int kMaxThreadCount = 8;
+const int kDistinctKeyCount = 1000;
+
+// equal keys with different tags show whether a merge is stable
+struct Record {
+    int64_t key;
+    int64_t tag;
+
+    bool operator==(const Record& other) const = default;
+};
+
+bool KeyLess(const Record& lhs, const Record& rhs) {
+    return lhs.key < rhs.key;
+}
+
+std::vector<std::vector<Record>> RecordRuns(int64_t total_size, int count) {
+    std::vector<std::vector<Record>> runs;
+    int64_t tag = 0;
+    for (const auto& values : SortedRuns(total_size, count)) {
+        runs.emplace_back();
+        for (int64_t value : values) {
+            runs.back().push_back({value % kDistinctKeyCount, tag++});
+        }
+        std::stable_sort(runs.back().begin(), runs.back().end(), KeyLess);
+    }
+    return runs;
+}
+
+template <int arity>
+void RunHeapMerge(const std::vector<std::vector<Record>>& runs,
+                  const std::vector<Record>& serial) {
+    std::vector<Record> merged(serial.size());
+    const auto kStart = Clock::now();
+    HeapKWayMerge<arity>(runs, merged.begin(), KeyLess);
+    PrintResult("heap",
+                "k=" + std::to_string(runs.size()) +
+                    " arity=" + std::to_string(arity),
+                serial.size(), Clock::now() - kStart, merged == serial);
+}
+
+void Run(int64_t total_size) {
+    for (int run_count : kRunCounts) {
+        const auto kRuns = RecordRuns(total_size, run_count);
+        std::vector<Record> expected;
+        for (const auto& run : kRuns) {
+            expected.insert(expected.end(), run.begin(), run.end());
+        }
+        std::stable_sort(expected.begin(), expected.end(), KeyLess);
+
+        std::vector<Record> serial(total_size);
+        const auto kSerialStart = Clock::now();
+        KWayMerge(kRuns, serial.begin(), KeyLess);
+        PrintResult("serial", "k=" + std::to_string(run_count), total_size,
+                    Clock::now() - kSerialStart, serial == expected);
+
+        RunHeapMerge<2>(kRuns, serial);
+        RunHeapMerge<4>(kRuns, serial);
+        RunHeapMerge<8>(kRuns, serial);
+
+        for (int thread_count = 1; thread_count <= kMaxThreadCount;
+             thread_count *= 2) {
+            std::vector<Record> merged(total_size);
+            const auto kStart = Clock::now();
+            KWayMerge(kRuns, merged.begin(), KeyLess, thread_count);
+            PrintResult("parallel",
+                        "k=" + std::to_string(run_count) +
+                            " threads=" + std::to_string(thread_count),
+                        total_size, Clock::now() - kStart, merged == serial);
+        }
+    }
+}
+
+}  // namespace InMemory
+
+int main(int argc, char** argv) {
+    const int64_t kDefaultTotalSize = 4'000'000;
+    const int64_t kTotalSize = argc > 1 ? std::stoll(argv[1])
+                                        : kDefaultTotalSize;
+
+    std::cout << std::setw(10) << "merge" << std::setw(24) << "setting"
+              << std::setw(10) << "ns/elem" << '\n';
+    External::Run(kTotalSize);
+    InMemory::Run(kTotalSize);
+
+    return 0;
+}
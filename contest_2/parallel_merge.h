@@ -0,0 +1,161 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "k_way_merge.h"
+#include "parallel_sort.h"
+
+namespace ParallelMerge {
+
+const int64_t kSequentialCutoff = 1 << 16;
+
+// Merge path of k runs: returns split such that the first split[q]
+// elements of every run q are exactly the rank first elements of the
+// merged output. Elements are ordered by compare, equivalent ones by run
+// and then by position, so every rank has exactly one split.
+//
+// Every run keeps an interval [low, high) known to contain its split. A
+// round takes the middle element of every nonempty interval, picks their
+// median weighted by interval length as the pivot and counts the elements
+// before it by binary search in every interval. The pivot is before or
+// after the split, and all runs move low or high to its position. At least
+// half of the interval weight lies on the cut side of the pivot, so the sum
+// of interval lengths drops by a quarter every round: O(log n) rounds of
+// O(k log n) comparisons.
+template <typename Iterator, typename Compare>
+std::vector<int64_t> CoRank(
+    const std::vector<std::pair<Iterator, Iterator>>& runs, int64_t rank,
+    Compare compare) {
+    const int kRunCount = runs.size();
+    std::vector<int64_t> low(kRunCount, 0);
+    std::vector<int64_t> high(kRunCount);
+    for (int run = 0; run < kRunCount; ++run) {
+        high[run] = std::distance(runs[run].first, runs[run].second);
+    }
+
+    struct Candidate {
+        int run;
+        int64_t position;
+        int64_t weight;
+    };
+    auto element = [&runs](int run, int64_t position) -> decltype(auto) {
+        return *(runs[run].first + position);
+    };
+    auto candidate_less = [&](const Candidate& lhs, const Candidate& rhs) {
+        const auto& lhs_value = element(lhs.run, lhs.position);
+        const auto& rhs_value = element(rhs.run, rhs.position);
+        if (compare(lhs_value, rhs_value)) {
+            return true;
+        }
+        return !compare(rhs_value, lhs_value) && lhs.run < rhs.run;
+    };
+
+    std::vector<Candidate> candidates;
+    std::vector<int64_t> positions(kRunCount);
+    while (true) {
+        candidates.clear();
+        int64_t total_weight = 0;
+        for (int run = 0; run < kRunCount; ++run) {
+            if (low[run] < high[run]) {
+                candidates.push_back({run, (low[run] + high[run]) / 2,
+                                      high[run] - low[run]});
+                total_weight += high[run] - low[run];
+            }
+        }
+        if (candidates.empty()) {
+            return low;
+        }
+        std::sort(candidates.begin(), candidates.end(), candidate_less);
+        auto pivot = candidates.begin();
+        for (int64_t weight = pivot->weight; 2 * weight < total_weight;
+             weight += pivot->weight) {
+            ++pivot;
+        }
+
+        // positions[q] is the number of elements of run q before the pivot
+        const auto& kPivotValue = element(pivot->run, pivot->position);
+        int64_t pivot_rank = 0;
+        for (int run = 0; run < kRunCount; ++run) {
+            const Iterator kFirst = runs[run].first;
+            if (run < pivot->run) {
+                positions[run] =
+                    std::upper_bound(kFirst + low[run], kFirst + high[run],
+                                     kPivotValue, compare) -
+                    kFirst;
+            } else if (run > pivot->run) {
+                positions[run] =
+                    std::lower_bound(kFirst + low[run], kFirst + high[run],
+                                     kPivotValue, compare) -
+                    kFirst;
+            } else {
+                positions[run] = pivot->position;
+            }
+            pivot_rank += positions[run];
+        }
+
+        if (pivot_rank < rank) {
+            ++positions[pivot->run];
+            low = positions;
+        } else {
+            high = positions;
+        }
+    }
+}
+
+}  // namespace ParallelMerge
+
+// Parallel version of KWayMerge on thread_count threads including the
+// calling one. The output is cut into thread_count slices of equal size,
+// CoRank finds where every slice starts in every run, and each thread
+// merges its slice into its own part of out with no synchronization. Both
+// merges are stable, so the result is the sequence of the serial
+// KWayMerge.
+template <typename Runs, typename RandomAccessIterator, typename Compare>
+RandomAccessIterator KWayMerge(const Runs& runs, RandomAccessIterator out,
+                               Compare compare, int thread_count) {
+    using Iterator = decltype(std::begin(*std::begin(runs)));
+    std::vector<std::pair<Iterator, Iterator>> cursors;
+    int64_t total_size = 0;
+    for (const auto& run : runs) {
+        cursors.emplace_back(std::begin(run), std::end(run));
+        total_size += std::distance(std::begin(run), std::end(run));
+    }
+    if (thread_count <= 1 || total_size < ParallelMerge::kSequentialCutoff) {
+        return KWayMerge(runs, out, compare);
+    }
+
+    std::vector<std::vector<int64_t>> splits(thread_count + 1);
+    CustomSort::WorkStealingPool pool(thread_count);
+    CustomSort::WorkStealingPool::TaskGroup group;
+    for (int slice = 0; slice <= thread_count; ++slice) {
+        pool.Spawn(group, [&, slice] {
+            splits[slice] = ParallelMerge::CoRank(
+                cursors, total_size * slice / thread_count, compare);
+        });
+    }
+    pool.Wait(group);
+
+    for (int slice = 0; slice < thread_count; ++slice) {
+        pool.Spawn(group, [&, slice] {
+            std::vector<std::pair<Iterator, Iterator>> slice_cursors;
+            for (size_t run = 0; run < cursors.size(); ++run) {
+                slice_cursors.emplace_back(
+                    cursors[run].first + splits[slice][run],
+                    cursors[run].first + splits[slice + 1][run]);
+            }
+            LoserTree<Iterator, Compare> tree(slice_cursors, compare);
+            auto slice_out = out + total_size * slice / thread_count;
+            while (!tree.Empty()) {
+                *slice_out++ = tree.Top();
+                tree.Pop();
+            }
+        });
+    }
+    pool.Wait(group);
+
+    return out + total_size;
+}
@@ -0,0 +1,336 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include "custom_sort.h"
+
+namespace CustomSort {
+
+// Fork-join pool, every thread owns a deque of tasks. The owner pushes and
+// pops at the back, idle threads steal the oldest task from the front of
+// another deque, so big subranges spread over the threads first. The
+// thread that created the pool works as thread 0 inside Wait, as does any
+// other thread that is not a worker of this pool. Workers without tasks
+// sleep until the next Spawn, Wait spins because it ends with the group.
+class WorkStealingPool {
+public:
+    using Task = std::function<void()>;
+
+    // counts unfinished tasks spawned into it
+    struct TaskGroup {
+        std::atomic<int> pending_count = 0;
+    };
+
+    WorkStealingPool(int thread_count) : queues_(thread_count) {
+        for (int index = 1; index < thread_count; ++index) {
+            threads_.emplace_back([this, index] { WorkerLoop(index); });
+        }
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    ~WorkStealingPool() {
+        {
+            std::lock_guard lock(idle_mutex_);
+            stop_ = true;
+        }
+        idle_condition_.notify_all();
+        for (auto& thread : threads_) {
+            thread.join();
+        }
+    }
+
+    int ThreadCount() const { return queues_.size(); }
+
+    // a thread that is not a worker of this pool spawns into queue 0
+    void Spawn(TaskGroup& group, Task task) {
+        group.pending_count.fetch_add(1);
+        {
+            WorkerQueue& queue = queues_[OwnIndex()];
+            std::lock_guard lock(queue.mutex);
+            queue.tasks.emplace_back([&group, task = std::move(task)] {
+                task();
+                group.pending_count.fetch_sub(1);
+            });
+        }
+        queued_count_.fetch_add(1);
+        // a worker that counted itself idle checks queued_count_ under
+        // idle_mutex_ before it sleeps, so it sees the task or is woken
+        if (idle_count_.load() > 0) {
+            { std::lock_guard lock(idle_mutex_); }
+            idle_condition_.notify_one();
+        }
+    }
+
+    // runs tasks until every task of group is finished
+    void Wait(const TaskGroup& group) {
+        while (group.pending_count.load() != 0) {
+            if (!RunOneTask()) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+private:
+    struct alignas(64) WorkerQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    // the pool the current thread works for and its index there
+    struct Worker {
+        const WorkStealingPool* pool;
+        int index;
+    };
+
+    static inline thread_local Worker current_worker_{nullptr, 0};
+
+    std::vector<WorkerQueue> queues_;
+    std::vector<std::thread> threads_;
+    std::atomic<bool> stop_ = false;
+    // tasks in the queues and workers that are going to sleep or sleep
+    std::atomic<int> queued_count_ = 0;
+    std::atomic<int> idle_count_ = 0;
+    std::mutex idle_mutex_;
+    std::condition_variable idle_condition_;
+
+    int OwnIndex() const {
+        return current_worker_.pool == this ? current_worker_.index : 0;
+    }
+
+    void WorkerLoop(int index) {
+        current_worker_ = {this, index};
+        while (!stop_) {
+            if (!RunOneTask()) {
+                std::unique_lock lock(idle_mutex_);
+                idle_count_.fetch_add(1);
+                idle_condition_.wait(lock, [this] {
+                    return stop_ || queued_count_.load() > 0;
+                });
+                idle_count_.fetch_sub(1);
+            }
+        }
+    }
+
+    bool RunOneTask() {
+        const int kOwnIndex = OwnIndex();
+        Task task;
+        {
+            WorkerQueue& own_queue = queues_[kOwnIndex];
+            std::lock_guard lock(own_queue.mutex);
+            if (!own_queue.tasks.empty()) {
+                task = std::move(own_queue.tasks.back());
+                own_queue.tasks.pop_back();
+            }
+        }
+        for (int step = 1; !task && step < ThreadCount(); ++step) {
+            WorkerQueue& victim =
+                queues_[(kOwnIndex + step) % ThreadCount()];
+            std::lock_guard lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+            }
+        }
+        if (!task) {
+            return false;
+        }
+        queued_count_.fetch_sub(1);
+        task();
+        return true;
+    }
+};
+
+namespace Parallel {
+
+const int64_t kSequentialCutoff = 1 << 15;
+const int64_t kParallelPartitionThreshold = 1 << 20;
+
+// swaps the count misplaced elements starting from misplaced number
+// first_number, intervals are [begin, end) offsets of misplaced elements
+template <typename Iterator>
+void SwapMisplaced(Iterator first,
+                   const std::vector<std::pair<int64_t, int64_t>>& left,
+                   const std::vector<std::pair<int64_t, int64_t>>& right,
+                   int64_t first_number, int64_t count) {
+    auto find_position = [first_number](const auto& intervals) {
+        size_t interval = 0;
+        int64_t skipped = first_number;
+        while (skipped >= intervals[interval].second -
+                              intervals[interval].first) {
+            skipped -=
+                intervals[interval].second - intervals[interval].first;
+            ++interval;
+        }
+        return std::make_pair(interval, intervals[interval].first + skipped);
+    };
+    auto [left_interval, left_offset] = find_position(left);
+    auto [right_interval, right_offset] = find_position(right);
+    for (int64_t index = 0; index < count; ++index) {
+        if (left_offset == left[left_interval].second) {
+            left_offset = left[++left_interval].first;
+        }
+        if (right_offset == right[right_interval].second) {
+            right_offset = right[++right_interval].first;
+        }
+        std::iter_swap(first + left_offset, first + right_offset);
+        ++left_offset;
+        ++right_offset;
+    }
+}
+
+// std::partition of [first, last) by predicate in ThreadCount() blocks:
+// every block is partitioned by its own task, then elements on the wrong
+// side of the global border are swapped, also split between tasks
+template <typename Iterator, typename Predicate>
+Iterator Partition(Iterator first, Iterator last, Predicate predicate,
+                   WorkStealingPool& pool) {
+    const int kBlockCount = pool.ThreadCount();
+    const int64_t kSize = std::distance(first, last);
+    const int64_t kBlockSize = (kSize + kBlockCount - 1) / kBlockCount;
+
+    std::vector<int64_t> true_counts(kBlockCount, 0);
+    WorkStealingPool::TaskGroup group;
+    for (int block = 0; block < kBlockCount; ++block) {
+        pool.Spawn(group, [=, &true_counts] {
+            Iterator block_first =
+                first + std::min(kSize, block * kBlockSize);
+            Iterator block_last =
+                first + std::min(kSize, (block + 1) * kBlockSize);
+            true_counts[block] =
+                std::distance(block_first, std::partition(block_first,
+                                                          block_last,
+                                                          predicate));
+        });
+    }
+    pool.Wait(group);
+
+    const int64_t kBorder =
+        std::accumulate(true_counts.begin(), true_counts.end(), int64_t{0});
+    // false elements before the border and true elements after it
+    std::vector<std::pair<int64_t, int64_t>> misplaced_false;
+    std::vector<std::pair<int64_t, int64_t>> misplaced_true;
+    int64_t misplaced_count = 0;
+    for (int block = 0; block < kBlockCount; ++block) {
+        const int64_t kBlockFirst = std::min(kSize, block * kBlockSize);
+        const int64_t kBlockMiddle = kBlockFirst + true_counts[block];
+        const int64_t kBlockLast = std::min(kSize, (block + 1) * kBlockSize);
+        if (kBlockMiddle < std::min(kBlockLast, kBorder)) {
+            misplaced_false.emplace_back(kBlockMiddle,
+                                         std::min(kBlockLast, kBorder));
+            misplaced_count += misplaced_false.back().second - kBlockMiddle;
+        }
+        if (std::max(kBlockFirst, kBorder) < kBlockMiddle) {
+            misplaced_true.emplace_back(std::max(kBlockFirst, kBorder),
+                                        kBlockMiddle);
+        }
+    }
+
+    const int64_t kSwapsPerTask =
+        (misplaced_count + kBlockCount - 1) / kBlockCount;
+    for (int64_t number = 0; number < misplaced_count;
+         number += kSwapsPerTask) {
+        const int64_t kCount =
+            std::min(kSwapsPerTask, misplaced_count - number);
+        pool.Spawn(group, [=, &misplaced_false, &misplaced_true] {
+            SwapMisplaced(first, misplaced_false, misplaced_true, number,
+                          kCount);
+        });
+    }
+    pool.Wait(group);
+
+    return first + kBorder;
+}
+
+// puts pivot in place and returns its position, the pivot is the median of
+// 3 or ninther like in the sequential sort
+template <typename Iterator, typename Comparator>
+Iterator PartitionAroundPivot(Iterator first, Iterator last,
+                              Comparator comparator, WorkStealingPool& pool) {
+    SelectPivot(first, last, comparator);
+    if (std::distance(first, last) < kParallelPartitionThreshold) {
+        return PartitionRight(first, last, comparator).first;
+    }
+    const auto kPivot = *first;
+    Iterator border = Partition(
+        std::next(first), last,
+        [&kPivot, comparator](const auto& elem) {
+            return comparator(elem, kPivot);
+        },
+        pool);
+    std::iter_swap(first, std::prev(border));
+    return std::prev(border);
+}
+
+template <typename Iterator, typename Comparator>
+void SortTask(Iterator first, Iterator last, Comparator comparator,
+              int bad_partitions_allowed, WorkStealingPool& pool,
+              WorkStealingPool::TaskGroup& group) {
+    while (std::distance(first, last) >= kSequentialCutoff) {
+        const auto kSize = std::distance(first, last);
+        Iterator pivot_it =
+            PartitionAroundPivot(first, last, comparator, pool);
+
+        // all other elements are not less than the pivot, skip its copies
+        if (pivot_it == first) {
+            const auto kPivot = *pivot_it;
+            first = std::partition(std::next(pivot_it), last,
+                                   [&kPivot, comparator](const auto& elem) {
+                                       return !comparator(kPivot, elem);
+                                   });
+            continue;
+        }
+
+        const auto kLeftSize = std::distance(first, pivot_it);
+        const auto kRightSize = std::distance(pivot_it, last) - 1;
+        if ((kLeftSize < kSize / 8 || kRightSize < kSize / 8) &&
+            --bad_partitions_allowed == 0) {
+            QuickSort(first, last, comparator);
+            return;
+        }
+
+        pool.Spawn(group, [=, &pool, &group] {
+            SortTask(first, pivot_it, comparator, bad_partitions_allowed, pool,
+                     group);
+        });
+        first = std::next(pivot_it);
+    }
+    QuickSort(first, last, comparator);
+}
+
+}  // namespace Parallel
+
+// Parallel version of QuickSort on thread_count threads including the
+// calling one. Subranges above kSequentialCutoff are split into tasks and
+// ranges above kParallelPartitionThreshold are partitioned by all threads.
+template <typename Iterator, typename Comparator>
+void QuickSort(Iterator first, Iterator last, Comparator comparator,
+               int thread_count) {
+    const auto kSize = std::distance(first, last);
+    if (thread_count <= 1 || kSize < Parallel::kSequentialCutoff) {
+        QuickSort(first, last, comparator);
+        return;
+    }
+    WorkStealingPool pool(thread_count);
+    WorkStealingPool::TaskGroup group;
+    const int kBadPartitionsAllowed =
+        std::bit_width(static_cast<uint64_t>(kSize));
+    pool.Spawn(group, [=, &pool, &group] {
+        Parallel::SortTask(first, last, comparator, kBadPartitionsAllowed,
+                           pool, group);
+    });
+    pool.Wait(group);
+}
+
+}  // namespace CustomSort
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>
+
+struct Player {
+    int64_t efficiency;
+    int index;
+
+    static int64_t Efficiency(const Player& player) {
+        return player.efficiency;
+    }
+    static int Index(const Player& player) { return player.index; }
+};
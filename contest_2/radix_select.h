@@ -0,0 +1,86 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Exact element of a given rank in a stream of 32-bit values that is too
+// large to store but can be replayed, such as the output of a seeded
+// generator or a file read twice. It takes two passes over the stream and
+// 2^16 counters of memory.
+//
+// The first pass counts the high 16-bit halves of the values, which tells
+// the high half of the answer. The second pass counts the low halves of
+// the values with that high half, which tells the low half. The same pass
+// sums the values below and above that bucket, so the sum of absolute
+// deviations from the answer comes without a third pass. Sums are 128-bit,
+// so 10^10 values and more do not overflow.
+namespace RadixSelect {
+
+const int kDigitBits = 16;
+const uint32_t kBucketCount = uint32_t{1} << kDigitBits;
+const uint32_t kDigitMask = kBucketCount - 1;
+
+// a GCC and Clang extension, __extension__ keeps -Wpedantic quiet about it
+__extension__ typedef unsigned __int128 UInt128;
+
+struct RankStatistics {
+    uint32_t value;
+    // sum of |x - value| over the stream
+    UInt128 absolute_deviation_sum;
+};
+
+// finds the bucket that holds rank, rank becomes the rank inside it
+inline uint32_t FindBucket(const std::vector<uint64_t>& counts,
+                           uint64_t& rank) {
+    uint32_t bucket = 0;
+    while (rank >= counts[bucket]) {
+        rank -= counts[bucket];
+        ++bucket;
+    }
+    return bucket;
+}
+
+// replay(visit) must call visit(uint32_t) for every value of the stream in
+// any order, it is called twice; rank is 0-based and less than the stream
+// size
+template <typename Replay>
+RankStatistics Select(Replay replay, uint64_t rank) {
+    std::vector<uint64_t> counts(kBucketCount, 0);
+    replay([&counts](uint32_t value) { ++counts[value >> kDigitBits]; });
+    const uint32_t kHigh = FindBucket(counts, rank);
+
+    std::fill(counts.begin(), counts.end(), 0);
+    uint64_t below_count = 0;
+    uint64_t above_count = 0;
+    UInt128 below_sum = 0;
+    UInt128 above_sum = 0;
+    replay([&](uint32_t value) {
+        const uint32_t kValueHigh = value >> kDigitBits;
+        if (kValueHigh == kHigh) {
+            ++counts[value & kDigitMask];
+        } else if (kValueHigh < kHigh) {
+            ++below_count;
+            below_sum += value;
+        } else {
+            ++above_count;
+            above_sum += value;
+        }
+    });
+    const uint32_t kLow = FindBucket(counts, rank);
+    const uint32_t kValue = (kHigh << kDigitBits) | kLow;
+
+    UInt128 deviation_sum = static_cast<UInt128>(kValue) * below_count -
+                            below_sum + above_sum -
+                            static_cast<UInt128>(kValue) * above_count;
+    for (uint32_t low = 0; low < kBucketCount; ++low) {
+        const uint32_t kBucketValue = (kHigh << kDigitBits) | low;
+        const uint32_t kDeviation = kBucketValue > kValue
+                                        ? kBucketValue - kValue
+                                        : kValue - kBucketValue;
+        deviation_sum += static_cast<UInt128>(kDeviation) * counts[low];
+    }
+    return {kValue, deviation_sum};
+}
+
+}  // namespace RadixSelect
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Queue that returns the aggregate value[front] op ... op value[back] for
+// any associative Op with identity element, Op need not be commutative:
+//
+//     SlidingWindowAggregator<int64_t, std::plus<>> sum_window(0);
+//     auto gcd = [](int64_t lhs, int64_t rhs) { return std::gcd(lhs, rhs); };
+//     SlidingWindowAggregator<int64_t, decltype(gcd)> gcd_window(0, gcd);
+//
+// It is the two-stacks queue without the flip spike. The window is split
+// into front1 [front_, back_start_) and front2 [back_start_, middle_) with
+// suffix aggregates and back [middle_, end_) with one running aggregate.
+// When back grows as big as the front, it becomes front2, and its suffix
+// aggregates are built in the background two steps per operation. Then
+// front2_total_ is appended to the aggregates of front1 and both become
+// one front. Both steps finish before front1 runs out, so every
+// operation costs O(1) combines in the worst case. Entries live in one
+// ring buffer that doubles when full; after Reserve nothing is allocated.
+template <typename T, typename Op>
+class SlidingWindowAggregator {
+private:
+    struct Entry {
+        T value;
+        // suffix aggregate up to the end of the front this entry belongs to
+        T aggregate;
+    };
+
+    T identity_;
+    Op op_;
+
+    std::vector<Entry> ring_;
+    size_t mask_ = 0;
+
+    // absolute positions, the entry of position i is ring_[i & mask_]
+    size_t front_ = 0;
+    size_t back_start_ = 0;
+    size_t middle_ = 0;
+    size_t end_ = 0;
+
+    T back_aggregate_;
+
+    // background work, only while rebuilding_
+    bool rebuilding_ = false;
+    T front2_total_;
+    // front2 aggregates are built for positions >= build_position_
+    size_t build_position_ = 0;
+    // front1 aggregates include front2_total_ for positions >= converted_
+    size_t converted_ = 0;
+
+    Entry& At(size_t position) { return ring_[position & mask_]; }
+    const Entry& At(size_t position) const { return ring_[position & mask_]; }
+
+    void Grow() {
+        std::vector<Entry> ring(ring_.empty() ? 1 : 2 * ring_.size(),
+                                Entry{identity_, identity_});
+        const size_t kMask = ring.size() - 1;
+        for (size_t position = front_; position != end_; ++position) {
+            ring[position & kMask] = std::move(At(position));
+        }
+        ring_ = std::move(ring);
+        mask_ = kMask;
+    }
+
+    void StartRebuild() {
+        rebuilding_ = true;
+        front2_total_ = std::move(back_aggregate_);
+        back_aggregate_ = identity_;
+        middle_ = end_;
+        build_position_ = middle_;
+        converted_ = back_start_;
+    }
+
+    void Step() {
+        if (build_position_ != back_start_) {
+            --build_position_;
+            Entry& entry = At(build_position_);
+            entry.aggregate =
+                build_position_ + 1 == middle_
+                    ? entry.value
+                    : op_(entry.value, At(build_position_ + 1).aggregate);
+        } else if (converted_ > front_) {
+            --converted_;
+            Entry& entry = At(converted_);
+            entry.aggregate = op_(entry.aggregate, front2_total_);
+        }
+    }
+
+    void FixUp() {
+        if (!rebuilding_ && back_start_ - front_ <= end_ - middle_ &&
+            end_ != middle_) {
+            StartRebuild();
+        }
+        if (rebuilding_) {
+            Step();
+            Step();
+            if (build_position_ == back_start_ && converted_ <= front_) {
+                rebuilding_ = false;
+                back_start_ = middle_;
+            }
+        }
+    }
+
+public:
+    SlidingWindowAggregator(T identity, Op op = Op())
+        : identity_(identity),
+          op_(std::move(op)),
+          back_aggregate_(identity),
+          front2_total_(identity) {}
+
+    size_t Size() const { return end_ - front_; }
+
+    bool Empty() const { return end_ == front_; }
+
+    void Reserve(size_t capacity) {
+        while (ring_.size() < capacity) {
+            Grow();
+        }
+    }
+
+    void PushBack(T value) {
+        if (Size() == ring_.size()) {
+            Grow();
+        }
+        back_aggregate_ = op_(back_aggregate_, value);
+        At(end_) = {std::move(value), identity_};
+        ++end_;
+        FixUp();
+    }
+
+    // queue must not be empty
+    void PopFront() {
+        ++front_;
+        FixUp();
+    }
+
+    T Query() const {
+        if (front_ == back_start_) {
+            return back_aggregate_;
+        }
+        if (rebuilding_) {
+            return op_(op_(At(front_).aggregate, front2_total_),
+                       back_aggregate_);
+        }
+        return op_(At(front_).aggregate, back_aggregate_);
+    }
+};
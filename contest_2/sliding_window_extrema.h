@@ -0,0 +1,356 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// Extrema of all windows of fixed width, van Herk/Gil-Werman algorithm.
+// The array is cut into blocks of width elements. The window starting at i
+// covers a suffix of the block of i and a prefix of the next block, so its
+// answer is Best(suffix[i], prefix[i + width - 1]). That is 3 comparisons
+// per element for any width.
+//
+// The prefix and suffix scans are dependency chains the compiler keeps
+// scalar. For maxima and minima of int32_t and float they have explicit
+// kernels when the target has AVX-512F (16 lanes) or AVX2 (8 lanes): a
+// vector is scanned in log2(lanes) permute and max steps, which is correct
+// because taking the best of an element twice changes nothing, and its
+// last lane carries into the next vector. Other types, comparators and
+// targets use the scalar scans. Float values must not be NaN. The combining
+// loop has independent iterations and is left to the auto-vectorizer.
+namespace SlidingWindow {
+
+template <typename T, typename Compare>
+struct Best {
+    Compare compare;
+
+    T operator()(T lhs, T rhs) const { return compare(lhs, rhs) ? rhs : lhs; }
+};
+
+// vector operations on T of the enabled instruction set, if there are any
+template <typename T>
+struct SimdTraits {
+    static constexpr bool kSupported = false;
+};
+
+#if defined(__AVX512F__)
+
+using SimdIndices = __m512i;
+
+// the zero-masked forms with all lanes set are the plain instructions, the
+// plain intrinsics of GCC 12 warn with -Wmaybe-uninitialized
+const __mmask16 kAllLanes = 0xFFFF;
+
+inline SimdIndices LoadIndices(const int32_t* indices) {
+    return _mm512_loadu_si512(indices);
+}
+
+template <>
+struct SimdTraits<int32_t> {
+    static constexpr bool kSupported = true;
+    static constexpr int kLanes = 16;
+    using Vector = __m512i;
+
+    static Vector Load(const int32_t* values) {
+        return _mm512_loadu_si512(values);
+    }
+    static void Store(int32_t* out, Vector vector) {
+        _mm512_storeu_si512(out, vector);
+    }
+    static Vector Broadcast(int32_t value) { return _mm512_set1_epi32(value); }
+    static Vector Max(Vector lhs, Vector rhs) {
+        return _mm512_maskz_max_epi32(kAllLanes, lhs, rhs);
+    }
+    static Vector Min(Vector lhs, Vector rhs) {
+        return _mm512_maskz_min_epi32(kAllLanes, lhs, rhs);
+    }
+    static Vector Permute(Vector vector, SimdIndices indices) {
+        return _mm512_maskz_permutexvar_epi32(kAllLanes, indices, vector);
+    }
+};
+
+template <>
+struct SimdTraits<float> {
+    static constexpr bool kSupported = true;
+    static constexpr int kLanes = 16;
+    using Vector = __m512;
+
+    static Vector Load(const float* values) { return _mm512_loadu_ps(values); }
+    static void Store(float* out, Vector vector) {
+        _mm512_storeu_ps(out, vector);
+    }
+    static Vector Broadcast(float value) { return _mm512_set1_ps(value); }
+    static Vector Max(Vector lhs, Vector rhs) {
+        return _mm512_maskz_max_ps(kAllLanes, lhs, rhs);
+    }
+    static Vector Min(Vector lhs, Vector rhs) {
+        return _mm512_maskz_min_ps(kAllLanes, lhs, rhs);
+    }
+    static Vector Permute(Vector vector, SimdIndices indices) {
+        return _mm512_maskz_permutexvar_ps(kAllLanes, indices, vector);
+    }
+};
+
+#elif defined(__AVX2__)
+
+using SimdIndices = __m256i;
+
+inline SimdIndices LoadIndices(const int32_t* indices) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices));
+}
+
+template <>
+struct SimdTraits<int32_t> {
+    static constexpr bool kSupported = true;
+    static constexpr int kLanes = 8;
+    using Vector = __m256i;
+
+    static Vector Load(const int32_t* values) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values));
+    }
+    static void Store(int32_t* out, Vector vector) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), vector);
+    }
+    static Vector Broadcast(int32_t value) { return _mm256_set1_epi32(value); }
+    static Vector Max(Vector lhs, Vector rhs) {
+        return _mm256_max_epi32(lhs, rhs);
+    }
+    static Vector Min(Vector lhs, Vector rhs) {
+        return _mm256_min_epi32(lhs, rhs);
+    }
+    static Vector Permute(Vector vector, SimdIndices indices) {
+        return _mm256_permutevar8x32_epi32(vector, indices);
+    }
+};
+
+template <>
+struct SimdTraits<float> {
+    static constexpr bool kSupported = true;
+    static constexpr int kLanes = 8;
+    using Vector = __m256;
+
+    static Vector Load(const float* values) { return _mm256_loadu_ps(values); }
+    static void Store(float* out, Vector vector) {
+        _mm256_storeu_ps(out, vector);
+    }
+    static Vector Broadcast(float value) { return _mm256_set1_ps(value); }
+    static Vector Max(Vector lhs, Vector rhs) {
+        return _mm256_max_ps(lhs, rhs);
+    }
+    static Vector Min(Vector lhs, Vector rhs) {
+        return _mm256_min_ps(lhs, rhs);
+    }
+    static Vector Permute(Vector vector, SimdIndices indices) {
+        return _mm256_permutevar8x32_ps(vector, indices);
+    }
+};
+
+#endif
+
+// maxima or minima of a type with vector operations
+template <typename T, typename Compare>
+constexpr bool kHasSimdScan =
+    SimdTraits<T>::kSupported && (std::is_same_v<Compare, std::less<T>> ||
+                                  std::is_same_v<Compare, std::greater<T>>);
+
+#if defined(__AVX2__)
+
+// Vector scans of SimdTraits<T>, lane j of a step reads lane j - shift or
+// j + shift clamped to the vector.
+template <typename T, typename Compare>
+class SimdScan {
+private:
+    using Traits = SimdTraits<T>;
+    using Vector = typename Traits::Vector;
+    using Indices = std::array<int32_t, Traits::kLanes>;
+
+    static constexpr int kLanes = Traits::kLanes;
+    static constexpr int kSteps = std::bit_width(unsigned{kLanes}) - 1;
+
+    static constexpr Indices Shifted(int shift) {
+        Indices indices{};
+        for (int lane = 0; lane < kLanes; ++lane) {
+            indices[lane] = std::clamp(lane + shift, 0, kLanes - 1);
+        }
+        return indices;
+    }
+
+    // up by 1, 2, 4, ... lanes, then down by as many
+    static constexpr std::array<Indices, 2 * kSteps> kShifts = [] {
+        std::array<Indices, 2 * kSteps> shifts{};
+        for (int step = 0; step < kSteps; ++step) {
+            shifts[step] = Shifted(-(1 << step));
+            shifts[kSteps + step] = Shifted(1 << step);
+        }
+        return shifts;
+    }();
+    static constexpr Indices kFirst = Shifted(-kLanes);
+    static constexpr Indices kLast = Shifted(kLanes);
+
+    static Vector Best(Vector lhs, Vector rhs) {
+        if constexpr (std::is_same_v<Compare, std::less<T>>) {
+            return Traits::Max(lhs, rhs);
+        } else {
+            return Traits::Min(lhs, rhs);
+        }
+    }
+
+    static Vector Permute(Vector vector, const Indices& indices) {
+        return Traits::Permute(vector, LoadIndices(indices.data()));
+    }
+
+public:
+    // out[t] = best of values[0, t] for t in [0, count), returns the number
+    // of elements done, a multiple of kLanes
+    static size_t Prefix(const T* values, size_t count, T* out) {
+        if (count < kLanes) {
+            return 0;
+        }
+        Vector carry = Traits::Broadcast(values[0]);
+        size_t index = 0;
+        for (; index + kLanes <= count; index += kLanes) {
+            Vector vector = Traits::Load(values + index);
+            for (int step = 0; step < kSteps; ++step) {
+                vector = Best(vector, Permute(vector, kShifts[step]));
+            }
+            vector = Best(vector, carry);
+            Traits::Store(out + index, vector);
+            carry = Permute(vector, kLast);
+        }
+        return index;
+    }
+
+    // out[t] = best of carry and values[t, count) for the last multiple of
+    // kLanes elements, returns the number of elements left at the front
+    static size_t Suffix(const T* values, size_t count, T carry, T* out) {
+        Vector carry_vector = Traits::Broadcast(carry);
+        size_t index = count;
+        for (; index >= kLanes; index -= kLanes) {
+            Vector vector = Traits::Load(values + index - kLanes);
+            for (int step = 0; step < kSteps; ++step) {
+                vector =
+                    Best(vector, Permute(vector, kShifts[kSteps + step]));
+            }
+            vector = Best(vector, carry_vector);
+            Traits::Store(out + index - kLanes, vector);
+            carry_vector = Permute(vector, kFirst);
+        }
+        return index;
+    }
+};
+
+#endif
+
+// Prefix and suffix scans, by SimdScan when there is one.
+template <typename T, typename Compare>
+class Scan {
+private:
+    Best<T, Compare> best_;
+
+public:
+    Scan(Compare compare) : best_{compare} {}
+
+    // out[t] = best of values[0, t] for t in [0, count)
+    void Prefix(const T* values, size_t count, T* out) const {
+        size_t index = 0;
+#if defined(__AVX2__)
+        if constexpr (kHasSimdScan<T, Compare>) {
+            index = SimdScan<T, Compare>::Prefix(values, count, out);
+        }
+#endif
+        if (index == 0 && count > 0) {
+            out[0] = values[0];
+            index = 1;
+        }
+        for (; index < count; ++index) {
+            out[index] = best_(out[index - 1], values[index]);
+        }
+    }
+
+    // out[t] = best of carry and values[t, count) for t in [0, count)
+    void Suffix(const T* values, size_t count, T carry, T* out) const {
+        size_t index = count;
+#if defined(__AVX2__)
+        if constexpr (kHasSimdScan<T, Compare>) {
+            index = SimdScan<T, Compare>::Suffix(values, count, carry, out);
+        }
+#endif
+        T suffix = index < count ? out[index] : carry;
+        while (index-- > 0) {
+            suffix = best_(suffix, values[index]);
+            out[index] = suffix;
+        }
+    }
+};
+
+// out[i] = best of array[i, i + width) for i in [0, size - width]
+template <typename T, typename Compare>
+void Extrema(const T* __restrict array, size_t size, size_t width,
+             T* __restrict out, Compare compare) {
+    assert(1 <= width && width <= size);
+    const Best<T, Compare> kBest{compare};
+    const Scan<T, Compare> kScan(compare);
+    const size_t kWindowCount = size - width + 1;
+    std::vector<T> prefix(width);
+
+    for (size_t block = 0; block < kWindowCount; block += width) {
+        const size_t kBlockWindows = std::min(width, kWindowCount - block);
+        const T* block_values = array + block;
+
+        // out[t] = best of block_values[t, width)
+        T suffix = block_values[width - 1];
+        for (size_t offset = width - 1; offset >= kBlockWindows; --offset) {
+            suffix = kBest(suffix, block_values[offset]);
+        }
+        kScan.Suffix(block_values, kBlockWindows, suffix, out + block);
+
+        // prefix[t] = best of next_block_values[0, t)
+        if (kBlockWindows > 1) {
+            kScan.Prefix(block_values + width, kBlockWindows - 1,
+                         prefix.data() + 1);
+        }
+
+        T* __restrict block_out = out + block;
+        const T* __restrict block_prefix = prefix.data();
+        for (size_t offset = 1; offset < kBlockWindows; ++offset) {
+            block_out[offset] = kBest(block_out[offset], block_prefix[offset]);
+        }
+    }
+}
+
+// empty if the array is shorter than width
+template <typename T>
+std::vector<T> Max(const std::vector<T>& array, size_t width) {
+    assert(width >= 1);
+    if (width > array.size()) {
+        return {};
+    }
+    std::vector<T> maxima(array.size() - width + 1);
+    Extrema(array.data(), array.size(), width, maxima.data(), std::less<T>());
+    return maxima;
+}
+
+// empty if the array is shorter than width
+template <typename T>
+std::vector<T> Min(const std::vector<T>& array, size_t width) {
+    assert(width >= 1);
+    if (width > array.size()) {
+        return {};
+    }
+    std::vector<T> minima(array.size() - width + 1);
+    Extrema(array.data(), array.size(), width, minima.data(),
+            std::greater<T>());
+    return minima;
+}
+
+}  // namespace SlidingWindow
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <utility>
+
+#include "array_statistics.h"
+#include "dary_heap.h"
+
+// Queue that keeps the median of its elements, the one of rank
+// floor(size / 2), and the sum of absolute deviations from it.
+//
+// The elements below the median rank are in the max-heap lower_, the rest
+// are in the min-heap upper_ with the median on top, and upper_ is never
+// smaller than lower_ nor larger by more than one. Both heaps have handles,
+// so the front element is erased right where it is instead of being
+// deleted lazily, and PushBack and PopFront take O(log size). With the sums
+// of both halves the deviation sum is
+//   median * |lower| - sum(lower) + sum(upper) - median * |upper|.
+template <typename T>
+class SlidingWindowMedian {
+private:
+    using Sum = ArrayStatistics::Sum<T>;
+    // the value and the number of the PushBack that added it
+    using Element = std::pair<T, size_t>;
+    template <typename Compare>
+    using Heap = DaryHeap<Element, Compare, 4, true>;
+    using Handle = typename Heap<std::less<>>::Handle;
+
+    struct Location {
+        bool in_upper;
+        Handle handle;
+    };
+
+    Heap<std::greater<>> lower_;
+    Heap<std::less<>> upper_;
+    Sum lower_sum_ = 0;
+    Sum upper_sum_ = 0;
+
+    // locations_[i] is the location of the element of PushBack number
+    // popped_count_ + i
+    std::deque<Location> locations_;
+    size_t popped_count_ = 0;
+
+    Location& LocationOf(size_t position) {
+        return locations_[position - popped_count_];
+    }
+
+    void MoveToUpper() {
+        const Element kElement = lower_.Pop();
+        lower_sum_ -= kElement.first;
+        upper_sum_ += kElement.first;
+        LocationOf(kElement.second) = {true, upper_.Push(kElement)};
+    }
+
+    void MoveToLower() {
+        const Element kElement = upper_.Pop();
+        upper_sum_ -= kElement.first;
+        lower_sum_ += kElement.first;
+        LocationOf(kElement.second) = {false, lower_.Push(kElement)};
+    }
+
+    void Rebalance() {
+        if (upper_.Size() > lower_.Size() + 1) {
+            MoveToLower();
+        } else if (upper_.Size() < lower_.Size()) {
+            MoveToUpper();
+        }
+    }
+
+public:
+    size_t Size() const { return locations_.size(); }
+
+    bool Empty() const { return locations_.empty(); }
+
+    void PushBack(T value) {
+        const Element kElement(value, popped_count_ + Size());
+        if (!upper_.Empty() && value < upper_.Top().first) {
+            lower_sum_ += value;
+            locations_.push_back({false, lower_.Push(kElement)});
+        } else {
+            upper_sum_ += value;
+            locations_.push_back({true, upper_.Push(kElement)});
+        }
+        Rebalance();
+    }
+
+    // queue must not be empty
+    void PopFront() {
+        assert(!Empty());
+        const Location kLocation = locations_.front();
+        if (kLocation.in_upper) {
+            upper_sum_ -= upper_.Erase(kLocation.handle).first;
+        } else {
+            lower_sum_ -= lower_.Erase(kLocation.handle).first;
+        }
+        locations_.pop_front();
+        ++popped_count_;
+        Rebalance();
+    }
+
+    // queue must not be empty
+    T Median() const {
+        assert(!Empty());
+        return upper_.Top().first;
+    }
+
+    // sum of |x - Median()| over the queue, 0 if it is empty
+    Sum AbsoluteDeviationSum() const {
+        if (Empty()) {
+            return 0;
+        }
+        const Sum kMedian = Median();
+        return kMedian * static_cast<Sum>(lower_.Size()) - lower_sum_ +
+               upper_sum_ - kMedian * static_cast<Sum>(upper_.Size());
+    }
+};
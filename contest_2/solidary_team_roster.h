@@ -0,0 +1,362 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "player.h"
+
+// Most effective solidary team of a roster that changes online.
+//
+// Players are kept in a treap ordered by (efficiency, index). Let a[i] be
+// the efficiency at sorted position i. The longest solidary team starting
+// at i takes every player from i with efficiency at most
+// pair_sum(i) = a[i] + a[i + 1], and the node of i stores its efficiency
+// team_sum(i). pair_sum does not decrease with i, so a player with
+// efficiency v at position p lies exactly in the teams of positions
+// [first i with pair_sum(i) >= v, p). Adding or removing it is one range
+// add of team_sums, and only the previous player gets a new pair_sum. The
+// answer is the maximal team_sum kept in the subtree aggregates.
+//
+// Every change is O(log n) expected, BestEfficiency is O(1) and BestTeam is
+// O(log n + team size). Efficiencies must be non-negative.
+class SolidaryTeamRoster {
+private:
+    static constexpr int kNoNode = -1;
+    static constexpr int64_t kNoNext = std::numeric_limits<int64_t>::max();
+    static constexpr int64_t kNoTeam = std::numeric_limits<int64_t>::min();
+
+    struct Node {
+        Player player;
+        uint32_t priority;
+        int left = kNoNode;
+        int right = kNoNode;
+        int size = 1;
+        int64_t efficiency_sum;
+        // a[i] + a[i + 1], kNoNext for the last player
+        int64_t pair_sum = kNoNext;
+        int64_t team_sum = 0;
+        // maximal team_sum in the subtree
+        int64_t best_team_sum = 0;
+        // pending add to team_sum of the children subtrees
+        int64_t lazy_add = 0;
+    };
+
+    std::vector<Node> nodes_;
+    std::vector<int> unused_nodes_;
+    std::unordered_map<int, int> node_by_index_;
+    std::mt19937 generator_;
+    int root_ = kNoNode;
+
+    int Size(int node) const { return node == kNoNode ? 0 : nodes_[node].size; }
+
+    int64_t EfficiencySum(int node) const {
+        return node == kNoNode ? 0 : nodes_[node].efficiency_sum;
+    }
+
+    int64_t BestTeamSum(int node) const {
+        return node == kNoNode ? kNoTeam : nodes_[node].best_team_sum;
+    }
+
+    int NewNode(const Player& player) {
+        int node;
+        if (unused_nodes_.empty()) {
+            node = nodes_.size();
+            nodes_.emplace_back();
+        } else {
+            node = unused_nodes_.back();
+            unused_nodes_.pop_back();
+            nodes_[node] = Node();
+        }
+        nodes_[node].player = player;
+        nodes_[node].priority = generator_();
+        nodes_[node].efficiency_sum = player.efficiency;
+        return node;
+    }
+
+    void Apply(int node, int64_t add) {
+        if (node == kNoNode) {
+            return;
+        }
+        nodes_[node].team_sum += add;
+        nodes_[node].best_team_sum += add;
+        nodes_[node].lazy_add += add;
+    }
+
+    void Push(int node) {
+        if (nodes_[node].lazy_add != 0) {
+            Apply(nodes_[node].left, nodes_[node].lazy_add);
+            Apply(nodes_[node].right, nodes_[node].lazy_add);
+            nodes_[node].lazy_add = 0;
+        }
+    }
+
+    void Pull(int node) {
+        Node& current = nodes_[node];
+        current.size = Size(current.left) + 1 + Size(current.right);
+        current.efficiency_sum = EfficiencySum(current.left) +
+                                 current.player.efficiency +
+                                 EfficiencySum(current.right);
+        current.best_team_sum =
+            std::max({BestTeamSum(current.left), current.team_sum,
+                      BestTeamSum(current.right)});
+    }
+
+    // first count players go to the left tree
+    std::pair<int, int> Split(int node, int count) {
+        if (node == kNoNode) {
+            return {kNoNode, kNoNode};
+        }
+        Push(node);
+        if (Size(nodes_[node].left) < count) {
+            auto [left, right] = Split(nodes_[node].right,
+                                       count - Size(nodes_[node].left) - 1);
+            nodes_[node].right = left;
+            Pull(node);
+            return {node, right};
+        }
+        auto [left, right] = Split(nodes_[node].left, count);
+        nodes_[node].left = right;
+        Pull(node);
+        return {left, node};
+    }
+
+    int Merge(int left, int right) {
+        if (left == kNoNode) {
+            return right;
+        }
+        if (right == kNoNode) {
+            return left;
+        }
+        if (nodes_[left].priority > nodes_[right].priority) {
+            Push(left);
+            nodes_[left].right = Merge(nodes_[left].right, right);
+            Pull(left);
+            return left;
+        }
+        Push(right);
+        nodes_[right].left = Merge(left, nodes_[right].left);
+        Pull(right);
+        return right;
+    }
+
+    // number of players for which is_before holds, it must hold for a
+    // prefix of the sorted order
+    template <typename Predicate>
+    int CountPrefix(Predicate is_before) const {
+        int count = 0;
+        for (int node = root_; node != kNoNode;) {
+            if (is_before(nodes_[node])) {
+                count += Size(nodes_[node].left) + 1;
+                node = nodes_[node].right;
+            } else {
+                node = nodes_[node].left;
+            }
+        }
+        return count;
+    }
+
+    int64_t PrefixEfficiency(int count) const {
+        int64_t sum = 0;
+        for (int node = root_; node != kNoNode && count > 0;) {
+            const int kLeftSize = Size(nodes_[node].left);
+            if (kLeftSize < count) {
+                sum += EfficiencySum(nodes_[node].left) +
+                       nodes_[node].player.efficiency;
+                count -= kLeftSize + 1;
+                node = nodes_[node].right;
+            } else {
+                node = nodes_[node].left;
+            }
+        }
+        return sum;
+    }
+
+    const Player& PlayerAt(int position) const {
+        int node = root_;
+        while (Size(nodes_[node].left) != position) {
+            if (Size(nodes_[node].left) < position) {
+                position -= Size(nodes_[node].left) + 1;
+                node = nodes_[node].right;
+            } else {
+                node = nodes_[node].left;
+            }
+        }
+        return nodes_[node].player;
+    }
+
+    // end position of the longest solidary team of a player with pair_sum
+    int TeamEnd(int64_t pair_sum) const {
+        return CountPrefix([pair_sum](const Node& node) {
+            return node.player.efficiency <= pair_sum;
+        });
+    }
+
+    // first position whose longest team holds a player with efficiency, the
+    // positions up to that player hold it too
+    int FirstTeamContaining(int64_t efficiency) const {
+        return CountPrefix([efficiency](const Node& node) {
+            return node.pair_sum < efficiency;
+        });
+    }
+
+    int Position(const Player& player) const {
+        return CountPrefix([&player](const Node& node) {
+            return std::make_pair(node.player.efficiency, node.player.index) <
+                   std::make_pair(player.efficiency, player.index);
+        });
+    }
+
+    // adds to team_sum of positions [first, last) of the subtree of node
+    void AddTeamSums(int node, int first, int last, int64_t add) {
+        if (node == kNoNode || first >= last || last <= 0 ||
+            first >= Size(node)) {
+            return;
+        }
+        if (first <= 0 && Size(node) <= last) {
+            Apply(node, add);
+            return;
+        }
+        Push(node);
+        const int kLeftSize = Size(nodes_[node].left);
+        AddTeamSums(nodes_[node].left, first, last, add);
+        if (first <= kLeftSize && kLeftSize < last) {
+            nodes_[node].team_sum += add;
+        }
+        AddTeamSums(nodes_[node].right, first - kLeftSize - 1,
+                    last - kLeftSize - 1, add);
+        Pull(node);
+    }
+
+    void SetTeam(int node, int position, int64_t pair_sum, int64_t team_sum) {
+        Push(node);
+        const int kLeftSize = Size(nodes_[node].left);
+        if (position < kLeftSize) {
+            SetTeam(nodes_[node].left, position, pair_sum, team_sum);
+        } else if (position > kLeftSize) {
+            SetTeam(nodes_[node].right, position - kLeftSize - 1, pair_sum,
+                    team_sum);
+        } else {
+            nodes_[node].pair_sum = pair_sum;
+            nodes_[node].team_sum = team_sum;
+        }
+        Pull(node);
+    }
+
+    // recomputes pair_sum and team_sum of the player at position
+    void Recompute(int position) {
+        const int64_t kPairSum =
+            position + 1 < Size(root_)
+                ? PlayerAt(position).efficiency +
+                      PlayerAt(position + 1).efficiency
+                : kNoNext;
+        const int64_t kTeamSum =
+            PrefixEfficiency(TeamEnd(kPairSum)) - PrefixEfficiency(position);
+        SetTeam(root_, position, kPairSum, kTeamSum);
+    }
+
+    void CollectPlayers(int node, int first, int last,
+                        std::vector<Player>& players) const {
+        if (node == kNoNode || first >= last) {
+            return;
+        }
+        const int kLeftSize = Size(nodes_[node].left);
+        CollectPlayers(nodes_[node].left, first, std::min(last, kLeftSize),
+                       players);
+        if (first <= kLeftSize && kLeftSize < last) {
+            players.push_back(nodes_[node].player);
+        }
+        CollectPlayers(nodes_[node].right, std::max(0, first - kLeftSize - 1),
+                       last - kLeftSize - 1, players);
+    }
+
+public:
+    SolidaryTeamRoster(uint32_t random_state = std::random_device{}())
+        : generator_(random_state) {}
+
+    int Size() const { return Size(root_); }
+
+    // index must not be in the roster
+    void AddPlayer(const Player& player) {
+        assert(player.efficiency >= 0);
+        assert(!node_by_index_.contains(player.index));
+        const int kPosition = Position(player);
+        AddTeamSums(root_, FirstTeamContaining(player.efficiency), kPosition,
+                    player.efficiency);
+
+        const int kNode = NewNode(player);
+        node_by_index_[player.index] = kNode;
+        auto [left, right] = Split(root_, kPosition);
+        root_ = Merge(Merge(left, kNode), right);
+
+        if (kPosition > 0) {
+            Recompute(kPosition - 1);
+        }
+        Recompute(kPosition);
+    }
+
+    // index must be in the roster
+    void RemovePlayer(int index) {
+        const auto kIt = node_by_index_.find(index);
+        assert(kIt != node_by_index_.end());
+        const int kNode = kIt->second;
+        const Player kPlayer = nodes_[kNode].player;
+        node_by_index_.erase(kIt);
+
+        const int kPosition = Position(kPlayer);
+        AddTeamSums(root_, FirstTeamContaining(kPlayer.efficiency), kPosition,
+                    -kPlayer.efficiency);
+
+        auto [left, rest] = Split(root_, kPosition);
+        root_ = Merge(left, Split(rest, 1).second);
+        unused_nodes_.push_back(kNode);
+
+        if (kPosition > 0) {
+            Recompute(kPosition - 1);
+        }
+    }
+
+    void UpdateEfficiency(int index, int64_t efficiency) {
+        RemovePlayer(index);
+        AddPlayer({efficiency, index});
+    }
+
+    // summary efficiency of the most effective solidary team, 0 if the
+    // roster is empty
+    int64_t BestEfficiency() const {
+        return root_ == kNoNode ? 0 : nodes_[root_].best_team_sum;
+    }
+
+    // players of the most effective solidary team in efficiency order
+    std::vector<Player> BestTeam() const {
+        if (root_ == kNoNode) {
+            return {};
+        }
+        const int64_t kBest = nodes_[root_].best_team_sum;
+        // adds of the ancestors not pushed into node yet
+        int64_t pending_add = 0;
+        int position = 0;
+        int node = root_;
+        while (nodes_[node].team_sum + pending_add != kBest) {
+            pending_add += nodes_[node].lazy_add;
+            const int kLeft = nodes_[node].left;
+            if (kLeft != kNoNode &&
+                nodes_[kLeft].best_team_sum + pending_add == kBest) {
+                node = kLeft;
+            } else {
+                position += Size(kLeft) + 1;
+                node = nodes_[node].right;
+            }
+        }
+        position += Size(nodes_[node].left);
+
+        std::vector<Player> team;
+        CollectPlayers(root_, position, TeamEnd(nodes_[node].pair_sum), team);
+        return team;
+    }
+};
@@ -0,0 +1,237 @@
+// Benchmarks CustomSort::QuickSort and GetKStatistics against std::sort and
+// std::nth_element on adversarial input distributions. For every run it
+// prints ns per element, comparisons and moves per element counted by an
+// instrumented value type, and peak heap memory taken by the algorithm.
+//
+//   sort_bench [max_size]    sizes are 10^3, 10^4, ... up to max_size
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "custom_sort.h"
+#include "k_statistics.h"
+
+namespace {
+
+struct Counters {
+    int64_t comparisons = 0;
+    int64_t moves = 0;
+    int64_t allocated_bytes = 0;
+    int64_t peak_allocated_bytes = 0;
+};
+
+Counters counters;
+
+}  // namespace
+
+void* operator new(size_t size) {
+    // the size is stored in front of the block to count it on delete
+    auto* block = static_cast<size_t*>(std::malloc(size + sizeof(max_align_t)));
+    if (block == nullptr) {
+        throw std::bad_alloc();
+    }
+    *block = size;
+    counters.allocated_bytes += size;
+    counters.peak_allocated_bytes =
+        std::max(counters.peak_allocated_bytes, counters.allocated_bytes);
+    return reinterpret_cast<char*>(block) + sizeof(max_align_t);
+}
+
+void operator delete(void* pointer) noexcept {
+    if (pointer == nullptr) {
+        return;
+    }
+    auto* block = reinterpret_cast<size_t*>(static_cast<char*>(pointer) -
+                                            sizeof(max_align_t));
+    counters.allocated_bytes -= *block;
+    std::free(block);
+}
+
+void operator delete(void* pointer, size_t /*size*/) noexcept {
+    operator delete(pointer);
+}
+
+// int64_t that counts its comparisons and moves, copies count as moves
+struct CountedValue {
+    int64_t value = 0;
+
+    CountedValue() = default;
+    CountedValue(int64_t value) : value(value) {}
+
+    CountedValue(const CountedValue& other) : value(other.value) {
+        ++counters.moves;
+    }
+    CountedValue& operator=(const CountedValue& other) {
+        value = other.value;
+        ++counters.moves;
+        return *this;
+    }
+
+    bool operator<(const CountedValue& other) const {
+        ++counters.comparisons;
+        return value < other.value;
+    }
+    bool operator>(const CountedValue& other) const {
+        ++counters.comparisons;
+        return value > other.value;
+    }
+    bool operator==(const CountedValue& other) const {
+        return value == other.value;
+    }
+};
+
+namespace Distribution {
+
+const int kRandomState = 667;
+const int kFewUniqueCount = 8;
+
+std::vector<int64_t> Random(int size) {
+    std::mt19937_64 generator(kRandomState);
+    std::vector<int64_t> array(size);
+    for (auto& x : array) {
+        x = generator() >> 1;
+    }
+    return array;
+}
+
+std::vector<int64_t> Sorted(int size) {
+    std::vector<int64_t> array(size);
+    for (int index = 0; index < size; ++index) {
+        array[index] = index;
+    }
+    return array;
+}
+
+std::vector<int64_t> Reverse(int size) {
+    std::vector<int64_t> array = Sorted(size);
+    std::reverse(array.begin(), array.end());
+    return array;
+}
+
+std::vector<int64_t> OrganPipe(int size) {
+    std::vector<int64_t> array(size);
+    for (int index = 0; index < size; ++index) {
+        array[index] = std::min(index, size - 1 - index);
+    }
+    return array;
+}
+
+std::vector<int64_t> FewUnique(int size) {
+    std::vector<int64_t> array = Random(size);
+    for (auto& x : array) {
+        x %= kFewUniqueCount;
+    }
+    return array;
+}
+
+std::vector<int64_t> AllEqual(int size) {
+    return std::vector<int64_t>(size, 1);
+}
+
+// Musser's median-of-3 killer, quadratic for quicksort that takes the
+// median of first, middle and last elements
+std::vector<int64_t> Killer(int size) {
+    std::vector<int64_t> array(size);
+    const int kHalf = size / 2;
+    for (int index = 1; index <= kHalf; ++index) {
+        array[index - 1] = index % 2 == 1 ? index : kHalf + index - 1;
+        array[kHalf + index - 1] = 2 * index;
+    }
+    if (size % 2 == 1) {
+        array.back() = size;
+    }
+    return array;
+}
+
+std::vector<std::pair<std::string, std::function<std::vector<int64_t>(int)>>>
+All() {
+    return {{"random", Random},         {"sorted", Sorted},
+            {"reverse", Reverse},       {"organ-pipe", OrganPipe},
+            {"few-unique", FewUnique},  {"all-equal", AllEqual},
+            {"killer", Killer}};
+}
+
+}  // namespace Distribution
+
+using Algorithm = std::function<void(std::vector<CountedValue>&)>;
+
+std::vector<std::pair<std::string, Algorithm>> Algorithms() {
+    return {{"CustomSort::QuickSort",
+             [](std::vector<CountedValue>& array) {
+                 CustomSort::QuickSort(array.begin(), array.end(),
+                                       std::less<>());
+             }},
+            {"std::sort",
+             [](std::vector<CountedValue>& array) {
+                 std::sort(array.begin(), array.end());
+             }},
+            {"GetKStatistics",
+             [](std::vector<CountedValue>& array) {
+                 const int kSize = array.size();
+                 GetKStatistics(array, 0, kSize, kSize / 2);
+             }},
+            {"std::nth_element", [](std::vector<CountedValue>& array) {
+                 std::nth_element(array.begin(),
+                                  array.begin() + array.size() / 2,
+                                  array.end());
+             }}};
+}
+
+void Run(const std::string& algorithm_name, const Algorithm& algorithm,
+         const std::string& distribution_name,
+         const std::vector<int64_t>& values) {
+    using Clock = std::chrono::steady_clock;
+    std::vector<CountedValue> array(values.begin(), values.end());
+
+    counters.comparisons = 0;
+    counters.moves = 0;
+    const int64_t kBytesBefore = counters.allocated_bytes;
+    counters.peak_allocated_bytes = kBytesBefore;
+
+    const auto kStart = Clock::now();
+    algorithm(array);
+    const auto kFinish = Clock::now();
+
+    const double kSize = values.size();
+    std::cout << std::setw(22) << algorithm_name << std::setw(12)
+              << distribution_name << std::setw(10) << values.size()
+              << std::fixed << std::setprecision(2) << std::setw(10)
+              << std::chrono::duration<double, std::nano>(kFinish - kStart)
+                         .count() /
+                     kSize
+              << std::setw(10) << counters.comparisons / kSize
+              << std::setw(10) << counters.moves / kSize << std::setw(12)
+              << counters.peak_allocated_bytes - kBytesBefore << '\n';
+}
+
+int main(int argc, char** argv) {
+    const int kDefaultMaxSize = 1'000'000;
+    const int kSizeStep = 10;
+    const int kMinSize = 1000;
+    const int kMaxSize = argc > 1 ? std::stoi(argv[1]) : kDefaultMaxSize;
+
+    std::cout << std::setw(22) << "algorithm" << std::setw(12) << "input"
+              << std::setw(10) << "size" << std::setw(10) << "ns/elem"
+              << std::setw(10) << "cmp/elem" << std::setw(10) << "mov/elem"
+              << std::setw(12) << "peak bytes" << '\n';
+
+    for (int size = kMinSize; size <= kMaxSize; size *= kSizeStep) {
+        for (const auto& [distribution_name, generate] : Distribution::All()) {
+            const std::vector<int64_t> kValues = generate(size);
+            for (const auto& [algorithm_name, algorithm] : Algorithms()) {
+                Run(algorithm_name, algorithm, distribution_name, kValues);
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <stdexcept>
+
+#include "memory_manager.h"
+
+// std::pmr::memory_resource over a preallocated byte arena with the same
+// largest-block-first policy as MemoryManager. The arena is cut into granules
+// of kGranule bytes; every allocation takes one extra granule in front of the
+// returned pointer that stores its MemoryBlock, like a malloc chunk header.
+// Every allocation and free is a heap operation of MemoryManager, so for
+// many small nodes it is slower than malloc: arena_memory_resource_bench
+// shows about 1.7x the time on std::list hash chains and 1.1x on
+// shared_ptr trees. The arena is for bounded, resettable memory, not speed.
+class ArenaMemoryResource : public std::pmr::memory_resource {
+public:
+    static const size_t kGranule = alignof(std::max_align_t);
+
+    // arena_bytes / kGranule must fit into int, at most 32 GiB
+    ArenaMemoryResource(size_t arena_bytes)
+        : granule_count_(GranuleCount(arena_bytes)),
+          arena_(new std::max_align_t[granule_count_]),
+          memory_manager_(granule_count_) {}
+
+    const MemoryManager<>& Manager() const { return memory_manager_; }
+
+private:
+    using Header = MemoryBlock*;
+
+    int granule_count_;
+    std::unique_ptr<std::max_align_t[]> arena_;
+    MemoryManager<> memory_manager_;
+
+    static int GranuleCount(size_t arena_bytes) {
+        if (arena_bytes / kGranule >
+            static_cast<size_t>(std::numeric_limits<int>::max())) {
+            throw std::length_error("arena of more than INT_MAX granules");
+        }
+        return arena_bytes / kGranule;
+    }
+
+    std::byte* GranuleAddress(int first_index) const {
+        return reinterpret_cast<std::byte*>(arena_.get()) +
+               static_cast<size_t>(first_index - 1) * kGranule;
+    }
+
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        // alignment above kGranule is reached by skipping granules
+        const size_t kPadding = alignment > kGranule ? alignment - kGranule : 0;
+        const size_t kGranules =
+            1 + (bytes + kPadding + kGranule - 1) / kGranule;
+        if (kGranules > static_cast<size_t>(granule_count_)) {
+            throw std::bad_alloc();
+        }
+
+        MemoryBlock* block = memory_manager_.Allocate(kGranules);
+        if (block == nullptr) {
+            throw std::bad_alloc();
+        }
+
+        auto address = reinterpret_cast<uintptr_t>(
+            GranuleAddress(block->first_index) + kGranule);
+        if (alignment > kGranule) {
+            address = (address + alignment - 1) & ~(alignment - 1);
+        }
+        void* pointer = reinterpret_cast<void*>(address);
+        *(static_cast<Header*>(pointer) - 1) = block;
+        return pointer;
+    }
+
+    void do_deallocate(void* pointer, size_t /*bytes*/,
+                       size_t /*alignment*/) override {
+        memory_manager_.Free(*(static_cast<Header*>(pointer) - 1));
+    }
+
+    bool do_is_equal(
+        const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
@@ -0,0 +1,126 @@
+// Compares ArenaMemoryResource with global new/delete on the node-heavy
+// patterns of this repo: std::list hash chains (contest_3/E.cpp) and
+// shared_ptr<Node> binary search trees (contest_4/C.cpp).
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <memory_resource>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "arena_memory_resource.h"
+
+namespace {
+
+const size_t kArenaBytes = size_t{1} << 30;
+const int kRandomState = 667;
+
+struct Node {
+    int value;
+    std::shared_ptr<Node> left_child;
+    std::shared_ptr<Node> right_child;
+
+    Node(int value) : value(value) {}
+};
+
+// inserts keys into std::list buckets like HashTable from contest_3/E.cpp
+int64_t HashChains(std::pmr::memory_resource* resource,
+                   const std::vector<int>& keys) {
+    const int kBucketCount = keys.size() / 4 + 1;
+    std::pmr::vector<std::pmr::list<int>> buckets(kBucketCount, resource);
+    for (int key : keys) {
+        buckets[key % kBucketCount].push_back(key);
+    }
+    int64_t checksum = 0;
+    for (const auto& bucket : buckets) {
+        checksum += bucket.size() * bucket.size();
+    }
+    return checksum;
+}
+
+std::shared_ptr<Node> Insert(std::shared_ptr<Node> root, int value,
+                             std::pmr::memory_resource* resource) {
+    auto node = std::allocate_shared<Node>(
+        std::pmr::polymorphic_allocator<Node>(resource), value);
+    if (root == nullptr) {
+        return node;
+    }
+    Node* current = root.get();
+    while (true) {
+        auto& child =
+            value < current->value ? current->left_child : current->right_child;
+        if (child == nullptr) {
+            child = node;
+            return root;
+        }
+        current = child.get();
+    }
+}
+
+int64_t Depth(const std::shared_ptr<Node>& node) {
+    if (node == nullptr) {
+        return 0;
+    }
+    return 1 + std::max(Depth(node->left_child), Depth(node->right_child));
+}
+
+// builds shared_ptr<Node> BST like ConstructBST from contest_4/C.cpp
+int64_t SharedPtrTree(std::pmr::memory_resource* resource,
+                      const std::vector<int>& keys) {
+    std::shared_ptr<Node> root;
+    for (int key : keys) {
+        root = Insert(std::move(root), key, resource);
+    }
+    return Depth(root);
+}
+
+template <typename Workload>
+double Measure(Workload workload, std::pmr::memory_resource* resource,
+               const std::vector<int>& keys) {
+    const int kRepeats = 5;
+    using Clock = std::chrono::steady_clock;
+    int64_t checksum = 0;
+    const auto kStart = Clock::now();
+    for (int repeat = 0; repeat < kRepeats; ++repeat) {
+        checksum += workload(resource, keys);
+    }
+    const auto kFinish = Clock::now();
+    if (checksum == -1) {
+        std::cout << checksum;
+    }
+    return std::chrono::duration<double, std::milli>(kFinish - kStart).count() /
+           kRepeats;
+}
+
+template <typename Workload>
+void Compare(const std::string& name, Workload workload,
+             const std::vector<int>& keys) {
+    ArenaMemoryResource arena(kArenaBytes);
+    const double kMallocMs =
+        Measure(workload, std::pmr::new_delete_resource(), keys);
+    const double kArenaMs = Measure(workload, &arena, keys);
+    std::cout << name << " (" << keys.size() << " keys): malloc " << kMallocMs
+              << " ms, arena " << kArenaMs << " ms" << std::endl;
+}
+
+}  // namespace
+
+int main() {
+    const int kKeyCount = 1'000'000;
+    std::mt19937 generator(kRandomState);
+    std::uniform_int_distribution<int> distrib(0, kKeyCount * 4);
+    std::vector<int> keys(kKeyCount);
+    for (auto& key : keys) {
+        key = distrib(generator);
+    }
+
+    Compare("list hash chains", HashChains, keys);
+    Compare("shared_ptr BST", SharedPtrTree, keys);
+
+    return 0;
+}
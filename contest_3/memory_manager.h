@@ -0,0 +1,364 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <deque>
+#include <ostream>
+#include <vector>
+
+struct MemoryBlock {
+    int size;
+    int first_index;
+    bool is_allocated;
+
+    // intrusive links of the list of blocks ordered by first_index
+    MemoryBlock* prev = nullptr;
+    MemoryBlock* next = nullptr;
+
+    // position inside IndexedMaxHeap, kNotInHeap for allocated blocks
+    static const int kNotInHeap = -1;
+    int heap_index = kNotInHeap;
+
+    // links of the SegregatedFreeLists class, kNoSizeClass if not in a list
+    static const int kNoSizeClass = -1;
+    int size_class = kNoSizeClass;
+    MemoryBlock* prev_free = nullptr;
+    MemoryBlock* next_free = nullptr;
+
+    MemoryBlock(int size, int first_index, bool is_allocated)
+        : size(size), first_index(first_index), is_allocated(is_allocated) {}
+
+    bool operator<(const MemoryBlock& other) const {
+        if (size != other.size) {
+            return size < other.size;
+        }
+        return first_index > other.first_index;
+    }
+
+    bool operator==(const MemoryBlock& other) const {
+        return size == other.size && first_index == other.first_index;
+    }
+};
+
+inline std::ostream& operator<<(std::ostream& os,
+                                const MemoryBlock& memory_block) {
+    os << "[" << memory_block.first_index << ", " << memory_block.size << ", "
+       << (memory_block.is_allocated ? "alloc" : "not alloc") << "]";
+    return os;
+}
+
+// Max-heap over free blocks keyed by (size, -first_index). Every block knows
+// its own position, so Erase and key updates touch only one root-to-leaf path.
+class IndexedMaxHeap {
+private:
+    std::vector<MemoryBlock*> tree_;
+
+    static int LeftChild(int index) { return 2 * index + 1; }
+    static int RightChild(int index) { return 2 * index + 2; }
+    static int Parent(int index) { return (index - 1) / 2; }
+
+    void Place(int index, MemoryBlock* block) {
+        tree_[index] = block;
+        block->heap_index = index;
+    }
+
+    void SiftUp(int index) {
+        MemoryBlock* block = tree_[index];
+        while (index != 0 && *tree_[Parent(index)] < *block) {
+            Place(index, tree_[Parent(index)]);
+            index = Parent(index);
+        }
+        Place(index, block);
+    }
+
+    void SiftDown(int index) {
+        MemoryBlock* block = tree_[index];
+        const int kSize = Size();
+        while (LeftChild(index) < kSize) {
+            int max_child_index = LeftChild(index);
+            if (RightChild(index) < kSize &&
+                *tree_[max_child_index] < *tree_[RightChild(index)]) {
+                max_child_index = RightChild(index);
+            }
+            if (!(*block < *tree_[max_child_index])) {
+                break;
+            }
+            Place(index, tree_[max_child_index]);
+            index = max_child_index;
+        }
+        Place(index, block);
+    }
+
+public:
+    int Size() const { return tree_.size(); }
+
+    bool Empty() const { return tree_.empty(); }
+
+    MemoryBlock* Top() const { return tree_.front(); }
+
+    void Push(MemoryBlock* block) {
+        tree_.push_back(block);
+        Place(Size() - 1, block);
+        SiftUp(Size() - 1);
+    }
+
+    void Erase(MemoryBlock* block) {
+        assert(block->heap_index != MemoryBlock::kNotInHeap);
+        const int kIndex = block->heap_index;
+        MemoryBlock* last_block = tree_.back();
+        tree_.pop_back();
+        block->heap_index = MemoryBlock::kNotInHeap;
+        if (last_block == block) {
+            return;
+        }
+        Place(kIndex, last_block);
+        SiftUp(kIndex);
+        SiftDown(last_block->heap_index);
+    }
+
+    // call after the key of block became smaller
+    void DecreaseKey(MemoryBlock* block) { SiftDown(block->heap_index); }
+
+    // largest free block, nullptr if it is smaller than size
+    MemoryBlock* FindFit(int size) const {
+        return !Empty() && Top()->size >= size ? Top() : nullptr;
+    }
+
+    int LargestFreeBlockSize() const { return Empty() ? 0 : Top()->size; }
+};
+
+// Free blocks smaller than kLargeSize are kept in intrusive lists by power of
+// two size class, class c holds sizes [2^c, 2^(c+1)). A bitmap of non-empty
+// classes finds the first class that surely fits a small request with one
+// find-first-set, and large blocks stay in IndexedMaxHeap and are taken
+// largest first. A small request is O(1) while some larger class or a large
+// block fits it. Otherwise the only blocks that may fit are in its own
+// class, and that list is walked: O(list length), but only close to running
+// out of memory, where rounding up would reject the request instead.
+// LargestFreeBlockSize walks a list as well and is meant for diagnostics.
+class SegregatedFreeLists {
+private:
+    static const int kClassCount = 12;
+    static const int kLargeSize = 1 << kClassCount;
+
+    std::array<MemoryBlock*, kClassCount> heads_{};
+    uint64_t non_empty_classes_ = 0;
+    int small_count_ = 0;
+    IndexedMaxHeap large_blocks_;
+
+    static int SizeClass(int size) {
+        return std::bit_width(static_cast<unsigned>(size)) - 1;
+    }
+
+    void PushSmall(MemoryBlock* block) {
+        const int kClass = SizeClass(block->size);
+        block->size_class = kClass;
+        block->prev_free = nullptr;
+        block->next_free = heads_[kClass];
+        if (heads_[kClass] != nullptr) {
+            heads_[kClass]->prev_free = block;
+        }
+        heads_[kClass] = block;
+        non_empty_classes_ |= uint64_t{1} << kClass;
+        ++small_count_;
+    }
+
+    void EraseSmall(MemoryBlock* block) {
+        const int kClass = block->size_class;
+        if (block->prev_free != nullptr) {
+            block->prev_free->next_free = block->next_free;
+        } else {
+            heads_[kClass] = block->next_free;
+        }
+        if (block->next_free != nullptr) {
+            block->next_free->prev_free = block->prev_free;
+        }
+        if (heads_[kClass] == nullptr) {
+            non_empty_classes_ &= ~(uint64_t{1} << kClass);
+        }
+        block->size_class = MemoryBlock::kNoSizeClass;
+        --small_count_;
+    }
+
+public:
+    int Size() const { return small_count_ + large_blocks_.Size(); }
+
+    bool Empty() const { return Size() == 0; }
+
+    void Push(MemoryBlock* block) {
+        if (block->size < kLargeSize) {
+            PushSmall(block);
+        } else {
+            large_blocks_.Push(block);
+        }
+    }
+
+    void Erase(MemoryBlock* block) {
+        if (block->size_class != MemoryBlock::kNoSizeClass) {
+            EraseSmall(block);
+        } else {
+            large_blocks_.Erase(block);
+        }
+    }
+
+    // call after the size of block became smaller
+    void DecreaseKey(MemoryBlock* block) {
+        if (block->size_class == MemoryBlock::kNoSizeClass &&
+            block->size >= kLargeSize) {
+            large_blocks_.DecreaseKey(block);
+            return;
+        }
+        if (block->size_class == SizeClass(block->size)) {
+            return;
+        }
+        Erase(block);
+        PushSmall(block);
+    }
+
+    // any block of the first class not smaller than size, sizes are rounded
+    // up to a power of two so blocks of the class of size itself are skipped;
+    // that class is walked, in O(its length), only when nothing else fits
+    MemoryBlock* FindFit(int size) const {
+        if (size >= kLargeSize) {
+            return large_blocks_.FindFit(size);
+        }
+        const int kMinClass = std::bit_width(static_cast<unsigned>(size - 1));
+        const uint64_t kFitClasses =
+            non_empty_classes_ & (~uint64_t{0} << kMinClass);
+        if (kFitClasses != 0) {
+            return heads_[std::countr_zero(kFitClasses)];
+        }
+        MemoryBlock* large_block = large_blocks_.FindFit(size);
+        if (large_block != nullptr) {
+            return large_block;
+        }
+        for (MemoryBlock* block = heads_[SizeClass(size)]; block != nullptr;
+             block = block->next_free) {
+            if (block->size >= size) {
+                return block;
+            }
+        }
+        return nullptr;
+    }
+
+    // walks the highest non-empty list when there are no large blocks,
+    // O(its length)
+    int LargestFreeBlockSize() const {
+        if (!large_blocks_.Empty() || non_empty_classes_ == 0) {
+            return large_blocks_.LargestFreeBlockSize();
+        }
+        int largest_size = 0;
+        const int kClass = std::bit_width(non_empty_classes_) - 1;
+        for (MemoryBlock* block = heads_[kClass]; block != nullptr;
+             block = block->next_free) {
+            largest_size = std::max(largest_size, block->size);
+        }
+        return largest_size;
+    }
+};
+
+// FreeBlocks chooses the block for every request: IndexedMaxHeap takes the
+// largest one, SegregatedFreeLists takes a small one from the size classes.
+template <typename FreeBlocks = IndexedMaxHeap>
+class MemoryManager {
+private:
+    // owns every block ever created, pointers stay valid on push_back
+    std::deque<MemoryBlock> blocks_storage_;
+    std::vector<MemoryBlock*> unused_blocks_;
+    FreeBlocks free_blocks_;
+    int64_t free_memory_;
+
+    MemoryBlock* CreateBlock(int size, int first_index, bool is_allocated) {
+        if (unused_blocks_.empty()) {
+            blocks_storage_.emplace_back(size, first_index, is_allocated);
+            return &blocks_storage_.back();
+        }
+        MemoryBlock* block = unused_blocks_.back();
+        unused_blocks_.pop_back();
+        *block = MemoryBlock(size, first_index, is_allocated);
+        return block;
+    }
+
+    static void InsertBefore(MemoryBlock* position, MemoryBlock* block) {
+        block->next = position;
+        block->prev = position->prev;
+        if (position->prev != nullptr) {
+            position->prev->next = block;
+        }
+        position->prev = block;
+    }
+
+    void Unlink(MemoryBlock* block) {
+        if (block->prev != nullptr) {
+            block->prev->next = block->next;
+        }
+        if (block->next != nullptr) {
+            block->next->prev = block->prev;
+        }
+        unused_blocks_.push_back(block);
+    }
+
+    // merges free neighbour into block, neighbour must be adjacent
+    void Absorb(MemoryBlock* block, MemoryBlock* neighbour) {
+        free_blocks_.Erase(neighbour);
+        block->size += neighbour->size;
+        block->first_index =
+            std::min(block->first_index, neighbour->first_index);
+        Unlink(neighbour);
+    }
+
+public:
+    MemoryManager(int memory_size) : free_memory_(memory_size) {
+        free_blocks_.Push(CreateBlock(memory_size, 1, false));
+    }
+
+    int64_t FreeMemory() const { return free_memory_; }
+
+    int LargestFreeBlockSize() const {
+        return free_blocks_.LargestFreeBlockSize();
+    }
+
+    int FreeBlocksCount() const { return free_blocks_.Size(); }
+
+    // returns nullptr if there is no free block of required size
+    MemoryBlock* Allocate(int size) {
+        MemoryBlock* fit_block = free_blocks_.FindFit(size);
+        if (fit_block == nullptr) {
+            return nullptr;
+        }
+        free_memory_ -= size;
+        if (fit_block->size == size) {
+            free_blocks_.Erase(fit_block);
+            fit_block->is_allocated = true;
+            return fit_block;
+        }
+
+        MemoryBlock* allocated_block =
+            CreateBlock(size, fit_block->first_index, true);
+        InsertBefore(fit_block, allocated_block);
+
+        fit_block->size -= size;
+        fit_block->first_index += size;
+        free_blocks_.DecreaseKey(fit_block);
+
+        return allocated_block;
+    }
+
+    void Free(MemoryBlock* block) {
+        assert(block->is_allocated);
+        block->is_allocated = false;
+        free_memory_ += block->size;
+
+        if (block->prev != nullptr && !block->prev->is_allocated) {
+            Absorb(block, block->prev);
+        }
+        if (block->next != nullptr && !block->next->is_allocated) {
+            Absorb(block, block->next);
+        }
+
+        free_blocks_.Push(block);
+    }
+};
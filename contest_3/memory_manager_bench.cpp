@@ -0,0 +1,436 @@
+// Replays allocation traces against MemoryManager with every free block
+// policy and reports throughput, p50/p99 operation latency, peak
+// fragmentation and free heap size over time. Fragmentation is sampled
+// every kFragmentationStep queries, as LargestFreeBlockSize of the
+// size-class policy walks a free list.
+//
+// A trace has the same format as the input of C.cpp: memory size, query
+// count and queries, positive value allocates, -t frees the block of query t.
+//
+//   memory_manager_bench                         all synthetic traces
+//   memory_manager_bench --replay <file>         captured trace
+//   memory_manager_bench --record <kind> <file>  save synthetic trace
+//   memory_manager_bench --threads               multithreaded scaling
+//
+// --threads runs the same random mix of allocations and frees on 1 to 32
+// threads against one MemoryManager behind a mutex and against
+// ThreadCachingMemoryManager with a shard per thread. It reports
+// throughput and rejections, and checks that all memory is free again
+// after every thread freed its blocks.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "memory_manager.h"
+#include "thread_caching_memory_manager.h"
+
+struct Trace {
+    int memory_size;
+    std::vector<int> queries;
+};
+
+Trace ReadTrace(std::istream& in) {
+    Trace trace;
+    int query_count;
+    in >> trace.memory_size >> query_count;
+    trace.queries.resize(query_count);
+    for (auto& query : trace.queries) {
+        in >> query;
+    }
+    return trace;
+}
+
+void WriteTrace(const Trace& trace, std::ostream& out) {
+    out << trace.memory_size << ' ' << trace.queries.size() << '\n';
+    for (auto query : trace.queries) {
+        out << query << '\n';
+    }
+}
+
+namespace SyntheticTrace {
+
+const int kMemorySize = 1 << 20;
+const int kQueryCount = 200'000;
+const int kRandomState = 667;
+
+// frees a uniformly random live allocation with probability free_probability
+template <typename SizeDistribution>
+Trace RandomFrees(SizeDistribution size_distribution,
+                  double free_probability) {
+    std::mt19937 generator(kRandomState);
+    std::bernoulli_distribution is_free(free_probability);
+
+    Trace trace{kMemorySize, {}};
+    std::vector<int> live_queries;
+    for (int query = 0; query < kQueryCount; ++query) {
+        if (!live_queries.empty() && is_free(generator)) {
+            std::uniform_int_distribution<int> distrib(
+                0, static_cast<int>(live_queries.size()) - 1);
+            const int kPosition = distrib(generator);
+            std::swap(live_queries[kPosition], live_queries.back());
+            trace.queries.push_back(-(live_queries.back() + 1));
+            live_queries.pop_back();
+        } else {
+            trace.queries.push_back(size_distribution(generator));
+            live_queries.push_back(query);
+        }
+    }
+    return trace;
+}
+
+Trace Uniform() {
+    const int kMaxSize = 4096;
+    std::uniform_int_distribution<int> size_distrib(1, kMaxSize);
+    return RandomFrees(size_distrib, 0.5);
+}
+
+Trace Bimodal() {
+    const int kSmallSize = 16;
+    const int kLargeMinSize = kMemorySize / 64;
+    const int kLargeMaxSize = kMemorySize / 16;
+    const double kLargeProbability = 0.05;
+
+    std::uniform_int_distribution<int> small_distrib(1, kSmallSize);
+    std::uniform_int_distribution<int> large_distrib(kLargeMinSize,
+                                                     kLargeMaxSize);
+    std::bernoulli_distribution is_large(kLargeProbability);
+    return RandomFrees(
+        [&](std::mt19937& generator) {
+            return is_large(generator) ? large_distrib(generator)
+                                       : small_distrib(generator);
+        },
+        0.5);
+}
+
+Trace Lifo() {
+    const int kMaxSize = 4096;
+    std::mt19937 generator(kRandomState);
+    std::uniform_int_distribution<int> size_distrib(1, kMaxSize);
+    std::bernoulli_distribution is_free(0.5);
+
+    Trace trace{kMemorySize, {}};
+    std::vector<int> live_queries;
+    for (int query = 0; query < kQueryCount; ++query) {
+        if (!live_queries.empty() && is_free(generator)) {
+            trace.queries.push_back(-(live_queries.back() + 1));
+            live_queries.pop_back();
+        } else {
+            trace.queries.push_back(size_distrib(generator));
+            live_queries.push_back(query);
+        }
+    }
+    return trace;
+}
+
+// every allocation lives for an exponentially distributed number of queries
+Trace RandomLifetime() {
+    const int kMaxSize = 4096;
+    const double kMeanLifetime = 500;
+    std::mt19937 generator(kRandomState);
+    std::uniform_int_distribution<int> size_distrib(1, kMaxSize);
+    std::exponential_distribution<double> lifetime_distrib(1 / kMeanLifetime);
+
+    using Death = std::pair<int, int>;  // (death query, allocation query)
+    std::priority_queue<Death, std::vector<Death>, std::greater<>> deaths;
+
+    Trace trace{kMemorySize, {}};
+    while (static_cast<int>(trace.queries.size()) < kQueryCount) {
+        const int kQuery = trace.queries.size();
+        if (!deaths.empty() && deaths.top().first <= kQuery) {
+            trace.queries.push_back(-(deaths.top().second + 1));
+            deaths.pop();
+        } else {
+            trace.queries.push_back(size_distrib(generator));
+            const int kLifetime = 1 + lifetime_distrib(generator);
+            deaths.emplace(kQuery + kLifetime, kQuery);
+        }
+    }
+    return trace;
+}
+
+std::vector<std::pair<std::string, std::function<Trace()>>> All() {
+    return {{"uniform", Uniform},
+            {"bimodal", Bimodal},
+            {"lifo", Lifo},
+            {"random-lifetime", RandomLifetime}};
+}
+
+}  // namespace SyntheticTrace
+
+struct ReplayReport {
+    // time spent inside Allocate and Free only
+    double seconds = 0;
+    std::vector<int64_t> latencies_ns;
+    // over the sampled queries
+    double peak_fragmentation = 0;
+    int rejected_count = 0;
+    // (query, free blocks count) sampled during replay
+    std::vector<std::pair<int, int>> heap_sizes;
+};
+
+template <typename FreeBlocks>
+double Fragmentation(const MemoryManager<FreeBlocks>& memory_manager) {
+    if (memory_manager.FreeMemory() == 0) {
+        return 0;
+    }
+    return 1.0 - static_cast<double>(memory_manager.LargestFreeBlockSize()) /
+                     memory_manager.FreeMemory();
+}
+
+template <typename FreeBlocks>
+ReplayReport Replay(const Trace& trace) {
+    const int kHeapSamples = 10;
+    const int kFragmentationStep = 64;
+    const int kQueryCount = trace.queries.size();
+    const int kSampleStep = std::max(1, kQueryCount / kHeapSamples);
+    using Clock = std::chrono::steady_clock;
+
+    MemoryManager<FreeBlocks> memory_manager(trace.memory_size);
+    std::vector<MemoryBlock*> allocated_blocks(kQueryCount, nullptr);
+
+    ReplayReport report;
+    report.latencies_ns.reserve(kQueryCount);
+
+    for (int query = 0; query < kQueryCount; ++query) {
+        const int kValue = trace.queries[query];
+        const auto kStart = Clock::now();
+        if (kValue > 0) {
+            allocated_blocks[query] = memory_manager.Allocate(kValue);
+        } else if (allocated_blocks[-kValue - 1] != nullptr) {
+            memory_manager.Free(allocated_blocks[-kValue - 1]);
+            allocated_blocks[-kValue - 1] = nullptr;
+        }
+        const auto kFinish = Clock::now();
+
+        report.latencies_ns.push_back(
+            std::chrono::nanoseconds(kFinish - kStart).count());
+        report.seconds +=
+            std::chrono::duration<double>(kFinish - kStart).count();
+        if (kValue > 0 && allocated_blocks[query] == nullptr) {
+            ++report.rejected_count;
+        }
+        if (query % kFragmentationStep == 0) {
+            report.peak_fragmentation = std::max(
+                report.peak_fragmentation, Fragmentation(memory_manager));
+        }
+        if (query % kSampleStep == 0) {
+            report.heap_sizes.emplace_back(query,
+                                           memory_manager.FreeBlocksCount());
+        }
+    }
+
+    return report;
+}
+
+int64_t Percentile(std::vector<int64_t> values, double fraction) {
+    if (values.empty()) {
+        return 0;
+    }
+    const size_t kIndex = fraction * (values.size() - 1);
+    std::nth_element(values.begin(), values.begin() + kIndex, values.end());
+    return values[kIndex];
+}
+
+void PrintReport(const std::string& name, const Trace& trace,
+                 const ReplayReport& report, std::ostream& os = std::cout) {
+    const double kP50 = 0.5;
+    const double kP99 = 0.99;
+    os << name << ": " << trace.queries.size() << " ops, "
+       << trace.queries.size() / report.seconds << " ops/s, p50 "
+       << Percentile(report.latencies_ns, kP50) << " ns, p99 "
+       << Percentile(report.latencies_ns, kP99) << " ns, peak fragmentation "
+       << report.peak_fragmentation << ", rejected " << report.rejected_count
+       << '\n';
+    os << "  free blocks:";
+    for (auto [query, heap_size] : report.heap_sizes) {
+        os << ' ' << query << ':' << heap_size;
+    }
+    os << '\n';
+}
+
+void ReplayWithAllPolicies(const std::string& name, const Trace& trace) {
+    PrintReport(name + " [largest-first]", trace,
+                Replay<IndexedMaxHeap>(trace));
+    PrintReport(name + " [size-classes]", trace,
+                Replay<SegregatedFreeLists>(trace));
+}
+
+namespace ThreadScaling {
+
+const int kMemorySize = 1 << 24;
+const int kOperationsPerThread = 200'000;
+const int kMaxThreadCount = 32;
+const int kRandomState = 667;
+
+using Allocation = ThreadCachingMemoryManager<>::Allocation;
+
+struct Report {
+    double seconds = 0;
+    std::atomic<int64_t> rejected_count = 0;
+};
+
+// mostly small requests with a tail of large ones, every other operation
+// frees a random live allocation; frees everything at the end
+template <typename Allocate, typename Free>
+void RandomOperations(int thread, Allocate allocate, Free free,
+                      Report& report) {
+    const int kSmallSize = 64;
+    const int kLargeSize = 4096;
+    const double kLargeProbability = 0.1;
+    std::mt19937 generator(kRandomState + thread);
+    std::bernoulli_distribution is_free(0.5);
+    std::bernoulli_distribution is_large(kLargeProbability);
+    std::uniform_int_distribution<int> small_distrib(1, kSmallSize);
+    std::uniform_int_distribution<int> large_distrib(1, kLargeSize);
+
+    std::vector<Allocation> live;
+    for (int operation = 0; operation < kOperationsPerThread; ++operation) {
+        if (!live.empty() && is_free(generator)) {
+            std::uniform_int_distribution<size_t> distrib(0, live.size() - 1);
+            std::swap(live[distrib(generator)], live.back());
+            free(live.back());
+            live.pop_back();
+            continue;
+        }
+        const int kSize = is_large(generator) ? large_distrib(generator)
+                                              : small_distrib(generator);
+        const Allocation kAllocation = allocate(kSize);
+        if (kAllocation.Empty()) {
+            ++report.rejected_count;
+        } else {
+            live.push_back(kAllocation);
+        }
+    }
+    for (auto allocation : live) {
+        free(allocation);
+    }
+}
+
+template <typename Worker>
+void RunThreads(int thread_count, Worker worker, Report& report) {
+    using Clock = std::chrono::steady_clock;
+    const auto kStart = Clock::now();
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < thread_count; ++thread) {
+        threads.emplace_back(worker, thread);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    report.seconds =
+        std::chrono::duration<double>(Clock::now() - kStart).count();
+}
+
+void PrintReport(const std::string& name, int thread_count,
+                 const Report& report, bool is_consistent) {
+    const int64_t kOperations =
+        static_cast<int64_t>(thread_count) * kOperationsPerThread;
+    std::cout << name << " x" << thread_count << ": "
+              << kOperations / report.seconds << " ops/s, rejected "
+              << report.rejected_count
+              << (is_consistent ? "" : ", MEMORY LEAKED") << std::endl;
+}
+
+void Run() {
+    for (int thread_count = 1; thread_count <= kMaxThreadCount;
+         thread_count *= 2) {
+        MemoryManager<> shared_manager(kMemorySize);
+        std::mutex shared_mutex;
+        Report shared_report;
+        RunThreads(
+            thread_count,
+            [&](int thread) {
+                RandomOperations(
+                    thread,
+                    [&](int size) {
+                        std::lock_guard lock(shared_mutex);
+                        return Allocation{shared_manager.Allocate(size), 0};
+                    },
+                    [&](Allocation allocation) {
+                        std::lock_guard lock(shared_mutex);
+                        shared_manager.Free(allocation.block);
+                    },
+                    shared_report);
+            },
+            shared_report);
+        PrintReport("mutex", thread_count, shared_report,
+                    shared_manager.FreeMemory() == kMemorySize);
+
+        ThreadCachingMemoryManager<> caching_manager(kMemorySize,
+                                                     thread_count);
+        Report caching_report;
+        RunThreads(
+            thread_count,
+            [&](int thread) {
+                ThreadCachingMemoryManager<>::ThreadCache cache(
+                    caching_manager);
+                RandomOperations(
+                    thread, [&](int size) { return cache.Allocate(size); },
+                    [&](Allocation allocation) { cache.Free(allocation); },
+                    caching_report);
+            },
+            caching_report);
+        PrintReport("thread-caching", thread_count, caching_report,
+                    caching_manager.FreeMemory() == kMemorySize);
+    }
+}
+
+}  // namespace ThreadScaling
+
+int main(int argc, char** argv) {
+    std::vector<std::string> args(argv + 1, argv + argc);
+
+    if (args.size() == 2 && args[0] == "--replay") {
+        std::ifstream in(args[1]);
+        if (!in) {
+            std::cerr << "cannot open " << args[1] << std::endl;
+            return 1;
+        }
+        Trace trace = ReadTrace(in);
+        ReplayWithAllPolicies(args[1], trace);
+        return 0;
+    }
+
+    if (args.size() == 3 && args[0] == "--record") {
+        for (const auto& [name, generate] : SyntheticTrace::All()) {
+            if (name == args[1]) {
+                std::ofstream out(args[2]);
+                WriteTrace(generate(), out);
+                return 0;
+            }
+        }
+        std::cerr << "unknown trace " << args[1] << std::endl;
+        return 1;
+    }
+
+    if (args.size() == 1 && args[0] == "--threads") {
+        ThreadScaling::Run();
+        return 0;
+    }
+
+    if (!args.empty()) {
+        std::cerr << "usage: " << argv[0]
+                  << " [--replay <file> | --record <kind> <file> | "
+                     "--threads]"
+                  << std::endl;
+        return 1;
+    }
+
+    for (const auto& [name, generate] : SyntheticTrace::All()) {
+        Trace trace = generate();
+        ReplayWithAllPolicies(name, trace);
+    }
+
+    return 0;
+}
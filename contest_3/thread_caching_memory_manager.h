@@ -0,0 +1,262 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <vector>
+
+#include "memory_manager.h"
+
+// MemoryManager that can be used from many threads. The memory is split
+// into shards, each one is a separate MemoryManager over its own range of
+// indices with its own mutex, so threads with different home shards never
+// contend. Small requests are rounded up to a power of two and served from
+// a ThreadCache that refills from and flushes to the shards in batches.
+//
+// Blocks never span two shards, so a request larger than MaxRequestSize(),
+// the size of the smallest shard, is rejected even on an empty manager.
+// Unlike MemoryManager this is no single largest-first arena: pick the
+// shard count so that the largest request fits into one shard.
+template <typename FreeBlocks = IndexedMaxHeap>
+class ThreadCachingMemoryManager {
+public:
+    struct Allocation {
+        MemoryBlock* block = nullptr;
+        int shard = -1;
+
+        bool Empty() const { return block == nullptr; }
+    };
+
+    static const int kClassCount = 12;
+    static const int kMaxSmallSize = 1 << (kClassCount - 1);
+
+    ThreadCachingMemoryManager(int memory_size, int shard_count)
+        : shard_size_(memory_size / shard_count), shards_(shard_count) {
+        for (int shard = 0; shard < shard_count; ++shard) {
+            const int kLastShardExtra =
+                (shard + 1 == shard_count ? memory_size % shard_count : 0);
+            shards_[shard].memory_manager =
+                std::make_unique<MemoryManager<FreeBlocks>>(
+                    shard_size_ + kLastShardExtra);
+        }
+    }
+
+    // global first index of an allocation, indices start from 1
+    int FirstIndex(Allocation allocation) const {
+        return allocation.shard * shard_size_ + allocation.block->first_index;
+    }
+
+    int MaxRequestSize() const { return shard_size_; }
+
+    // free memory of all shards, blocks held by caches count as allocated
+    int64_t FreeMemory() {
+        int64_t free_memory = 0;
+        for (auto& shard : shards_) {
+            std::lock_guard lock(shard.mutex);
+            free_memory += shard.memory_manager->FreeMemory();
+        }
+        return free_memory;
+    }
+
+    // Per-thread front end, every worker owns one. Freed small blocks stay
+    // allocated in their shard and are reused by the next request of the
+    // same class; the rest goes back to the shards on overflow and on
+    // destruction. A refill takes at most 1 / kBatchShardFraction of a
+    // shard. A request the shards cannot serve flushes this cache and every
+    // other cache that is not busy at the moment, and is retried with its
+    // exact size, so only blocks of caches in the middle of their own
+    // operation can make it fail.
+    class ThreadCache {
+    public:
+        ThreadCache(ThreadCachingMemoryManager& owner)
+            : owner_(owner),
+              home_shard_(owner.next_home_shard_.fetch_add(1) %
+                          owner.shards_.size()) {
+            std::lock_guard lock(owner_.caches_mutex_);
+            owner_.caches_.push_back(this);
+        }
+
+        ThreadCache(const ThreadCache&) = delete;
+        ThreadCache& operator=(const ThreadCache&) = delete;
+
+        ~ThreadCache() {
+            {
+                std::lock_guard lock(owner_.caches_mutex_);
+                std::erase(owner_.caches_, this);
+            }
+            Flush();
+        }
+
+        // returns an empty allocation if no shard has a fitting block or
+        // size is larger than MaxRequestSize()
+        Allocation Allocate(int size) {
+            if (size > owner_.MaxRequestSize()) {
+                return {};
+            }
+            std::lock_guard lock(mutex_);
+            if (size > kMaxSmallSize) {
+                return AllocateExact(size);
+            }
+            const int kClass = SizeClass(size);
+            auto& cached = cache_[kClass];
+            if (cached.empty()) {
+                const int kClassSize = 1 << kClass;
+                const int kCount = std::clamp(
+                    owner_.shard_size_ / kBatchShardFraction / kClassSize, 1,
+                    kBatchSize);
+                owner_.AllocateBatch(home_shard_, kClassSize, kCount, cached);
+                if (cached.empty()) {
+                    return AllocateExact(size);
+                }
+            }
+            Allocation allocation = cached.back();
+            cached.pop_back();
+            return allocation;
+        }
+
+        void Free(Allocation allocation) {
+            const int kSize = allocation.block->size;
+            // blocks of AllocateExact are not of a class size
+            if (kSize > kMaxSmallSize ||
+                !std::has_single_bit(static_cast<unsigned>(kSize))) {
+                owner_.FreeOne(allocation);
+                return;
+            }
+            std::lock_guard lock(mutex_);
+            auto& cached = cache_[SizeClass(kSize)];
+            cached.push_back(allocation);
+            if (cached.size() > kMaxCached) {
+                owner_.FreeBatch(std::span(cached).last(kBatchSize));
+                cached.resize(cached.size() - kBatchSize);
+            }
+        }
+
+    private:
+        friend class ThreadCachingMemoryManager;
+
+        static constexpr int kBatchSize = 32;
+        static constexpr int kBatchShardFraction = 64;
+        static constexpr size_t kMaxCached = 2 * kBatchSize;
+
+        ThreadCachingMemoryManager& owner_;
+        int home_shard_;
+        std::array<std::vector<Allocation>, kClassCount> cache_;
+        // held by the owning thread during every operation and by other
+        // threads while they flush this cache
+        std::mutex mutex_;
+
+        static int SizeClass(int size) {
+            return std::bit_width(static_cast<unsigned>(size - 1));
+        }
+
+        // mutex_ must be held, or the cache must be unregistered already
+        void Flush() {
+            for (auto& cached : cache_) {
+                owner_.FreeBatch(cached);
+                cached.clear();
+            }
+        }
+
+        // size as is from the shards, flushes the caches and retries once;
+        // mutex_ must be held
+        Allocation AllocateExact(int size) {
+            Allocation allocation =
+                owner_.AllocateFromShards(home_shard_, size);
+            if (allocation.Empty()) {
+                Flush();
+                owner_.FlushOtherCaches(this);
+                allocation = owner_.AllocateFromShards(home_shard_, size);
+            }
+            return allocation;
+        }
+    };
+
+private:
+    // own cache line for every shard, so the mutexes do not false share
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::unique_ptr<MemoryManager<FreeBlocks>> memory_manager;
+    };
+
+    int shard_size_;
+    std::vector<Shard> shards_;
+    std::atomic<int> next_home_shard_ = 0;
+
+    std::mutex caches_mutex_;
+    std::vector<ThreadCache*> caches_;
+
+    // tries the home shard first and then the others in order
+    Allocation AllocateFromShards(int home_shard, int size) {
+        const int kShardCount = shards_.size();
+        for (int step = 0; step < kShardCount; ++step) {
+            const int kShard = (home_shard + step) % kShardCount;
+            std::lock_guard lock(shards_[kShard].mutex);
+            MemoryBlock* block =
+                shards_[kShard].memory_manager->Allocate(size);
+            if (block != nullptr) {
+                return {block, kShard};
+            }
+        }
+        return {};
+    }
+
+    // up to count blocks of size from the first shard that has any
+    void AllocateBatch(int home_shard, int size, int count,
+                       std::vector<Allocation>& allocations) {
+        const int kShardCount = shards_.size();
+        for (int step = 0; step < kShardCount; ++step) {
+            const int kShard = (home_shard + step) % kShardCount;
+            std::lock_guard lock(shards_[kShard].mutex);
+            for (int index = 0; index < count; ++index) {
+                MemoryBlock* block =
+                    shards_[kShard].memory_manager->Allocate(size);
+                if (block == nullptr) {
+                    break;
+                }
+                allocations.push_back({block, kShard});
+            }
+            if (!allocations.empty()) {
+                return;
+            }
+        }
+    }
+
+    void FreeOne(Allocation allocation) {
+        std::lock_guard lock(shards_[allocation.shard].mutex);
+        shards_[allocation.shard].memory_manager->Free(allocation.block);
+    }
+
+    // takes every shard lock once for all of its blocks, reorders them
+    void FreeBatch(std::span<Allocation> allocations) {
+        std::sort(allocations.begin(), allocations.end(),
+                  [](Allocation lhs, Allocation rhs) {
+                      return lhs.shard < rhs.shard;
+                  });
+        auto first = allocations.begin();
+        while (first != allocations.end()) {
+            const int kShard = first->shard;
+            std::lock_guard lock(shards_[kShard].mutex);
+            for (; first != allocations.end() && first->shard == kShard;
+                 ++first) {
+                shards_[kShard].memory_manager->Free(first->block);
+            }
+        }
+    }
+
+    // caches busy with their own operation are skipped: waiting for them
+    // could deadlock with one that flushes this cache at the same time
+    void FlushOtherCaches(ThreadCache* self) {
+        std::lock_guard lock(caches_mutex_);
+        for (ThreadCache* cache : caches_) {
+            if (cache != self && cache->mutex_.try_lock()) {
+                cache->Flush();
+                cache->mutex_.unlock();
+            }
+        }
+    }
+};